@@ -7,15 +7,8 @@ namespace dns
 {
 
     AbstractZoneImp::AbstractZoneImp( const Domainname &zone_name )
-        : mApex( zone_name )
-    {
-	mOwnerToNode.insert( OwnerToNodePair( mApex, NodePtr( new Node ) ) );
-    }
-
-    void AbstractZoneImp::addEmptyNode( const Domainname &domainname )
-    {
-        mOwnerToNode.insert( OwnerToNodePair( domainname, NodePtr( new Node ) ) );
-    }
+        : mArena( new utils::Arena ), mNodes( zone_name, mArena ), mApex( zone_name )
+    {}
 
     void AbstractZoneImp::add( RRSetPtr rrset )
     {
@@ -24,17 +17,11 @@ namespace dns
             throw std::runtime_error( "owner " + owner.toString() + "is not contained in " + mApex.toString() );
         }
 
-	Domainname relative_name = mApex.getRelativeDomainname( owner );
-	Domainname node_name     = mApex;
-	for ( auto r = relative_name.getCanonicalLabels().rbegin() ; r != relative_name.getCanonicalLabels().rend() ; ++r ) {
-	    node_name.addSubdomain( *r );
-	    if ( ! findNode( node_name ) )
-		addEmptyNode( node_name );
-	}
-	auto node = findNode( owner );
-	if ( node.get() == nullptr )
-	    throw std::logic_error( "node must be exist" );
+	auto node = mNodes.add( owner );
+	rrset->compile();
 	node->add( rrset );
+	if ( mResponseCache )
+	    mResponseCache->clear();
 
 	if ( rrset->getType() == TYPE_SOA && rrset->getOwner() == mApex ) {
 	    mSOA = rrset;
@@ -44,68 +31,101 @@ namespace dns
 	}	
     }
 
-    MessageInfo AbstractZoneImp::getAnswer( const MessageInfo &query ) const
+    static void initializeResponse( MessageInfo &response, uint16_t id, Opcode opcode,
+                                    bool recursion_desired, bool checking_disabled )
     {
-	Domainname qname  = mApex;
-        Type       qtype  = TYPE_SOA;
-        Class      qclass = CLASS_IN;
-
-	if ( query.mQuestionSection.size() != 0 ) {
-	    qname  = query.mQuestionSection[0].mDomainname;
-	    qtype  = query.mQuestionSection[0].mType;
-	    qclass = query.mQuestionSection[0].mClass;
-        }
-
-        MessageInfo response;
-
-        response.mID                  = query.mID;
-        response.mOpcode              = query.mOpcode;
+        response.mID                  = id;
+        response.mOpcode              = opcode;
         response.mQueryResponse       = 1;
         response.mAuthoritativeAnswer = 1;
         response.mTruncation          = 0;
-        response.mRecursionDesired    = query.mRecursionDesired;
+        response.mRecursionDesired    = recursion_desired;
         response.mRecursionAvailable  = 0;
         response.mZeroField           = 0;
         response.mAuthenticData       = 1;
-        response.mCheckingDisabled    = query.mCheckingDisabled;
-
-	if ( query.isEDNS0() ) {
-	    OptPseudoRecord opt;
-	    opt.mPayloadSize = std::min<uint16_t>( 1280, query.mOptPseudoRR.mPayloadSize );
-	    opt.mDOBit = query.mOptPseudoRR.mDOBit;
-	    response.mIsEDNS0 = true;
-	    response.mOptPseudoRR = opt;
-	}
+        response.mCheckingDisabled    = checking_disabled;
+    }
 
+    static void setOptPseudoRecord( MessageInfo &response, uint16_t payload_size, bool dobit )
+    {
+        OptPseudoRecord opt;
+        opt.mPayloadSize = std::min<uint16_t>( 1280, payload_size );
+        opt.mDOBit = dobit;
+        response.mIsEDNS0 = true;
+        response.mOptPseudoRR = opt;
+    }
+
+    MessageInfo AbstractZoneImp::getAnswer( const MessageInfo &query ) const
+    {
         QuestionSectionEntry q;
-        q.mDomainname = qname;
-        q.mType       = qtype;
-        q.mClass      = qclass;
-        response.mQuestionSection.push_back( q );
+        q.mDomainname = mApex;
+        q.mType       = TYPE_SOA;
+        q.mClass      = CLASS_IN;
+	if ( query.mQuestionSection.size() != 0 )
+	    q = query.mQuestionSection[0];
+
+        MessageInfo response;
+        initializeResponse( response, query.mID, query.mOpcode, query.mRecursionDesired, query.mCheckingDisabled );
+	if ( query.isEDNS0() )
+	    setOptPseudoRecord( response, query.mOptPseudoRR.mPayloadSize, query.mOptPseudoRR.mDOBit );
+
+        getAnswer( q, response );
+        return response;
+    }
+
+    MessageInfo AbstractZoneImp::getAnswer( const MessageView &query ) const
+    {
+        QuestionSectionEntry q;
+        q.mDomainname = mApex;
+        q.mType       = TYPE_SOA;
+        q.mClass      = CLASS_IN;
+	if ( query.hasQuestion() ) {
+	    q.mDomainname = query.getQuestionDomainname();
+	    q.mType       = query.getQuestionType();
+	    q.mClass      = query.getQuestionClass();
+        }
+
+        MessageInfo response;
+        initializeResponse( response, query.getID(), query.getOpcode(), query.getRecursionDesired(), query.getCheckingDisabled() );
+	if ( query.isEDNS0() )
+	    setOptPseudoRecord( response, query.getPayloadSize(), query.getDOBit() );
+
+        getAnswer( q, response );
+        return response;
+    }
+
+    void AbstractZoneImp::getAnswer( const QuestionSectionEntry &question, MessageInfo &response ) const
+    {
+	const Domainname &qname = question.mDomainname;
+        Type              qtype = question.mType;
+
+        response.mQuestionSection.push_back( question );
 
         if ( ! mApex.isSubDomain( qname ) ) {
             response.mResponseCode = REFUSED;
-            return response;
+            return;
         }
 
+	// find qname, closest encloser, delegation point, DNAME and wildcard in one descent
+        NodeTree::LookupResult result = mNodes.lookup( qname );
+
         if ( qtype == TYPE_RRSIG ) {
-	    responseRRSIG( qname, response );
-	    return response;
+	    responseRRSIG( qname, response, result );
+	    return;
         }
 
         if ( qtype == TYPE_NSEC ) {
-	    responseNSEC( qname, response );
-	    return response;
+	    responseNSEC( qname, response, result );
+	    return;
         }
 
         if ( qtype == TYPE_DNSKEY && qname == mApex ) {
             responseDNSKEY( qname, response );
-            return response;
+            return;
         }
 
-	// find qname
-        auto node = findNode( qname );
-        if ( node ) {
+        if ( result.mNode ) {
+            auto node = result.mNode->second;
             auto cname_rrset = node->find( TYPE_CNAME );
             if ( cname_rrset ) {
                 if ( cname_rrset->count() != 1 ) {
@@ -117,17 +137,17 @@ namespace dns
                 addRRSet( response.mAnswerSection, *cname_rrset );
 		addRRSIG( response, response.mAnswerSection, *cname_rrset );
 
-                std::shared_ptr<RecordCNAME> cname = std::dynamic_pointer_cast<RecordCNAME>( (*cname_rrset)[0] );
+                std::shared_ptr<const RecordCNAME> cname = std::dynamic_pointer_cast<const RecordCNAME>( (*cname_rrset)[0] );
                 auto canonical_name = cname->getCanonicalName();
-                if (mApex.isSubDomain( canonical_name ) ) {
-                    auto canonical_node  = findNode( canonical_name );
+                auto canonical_node = findNode( canonical_name );
+                if ( canonical_node ) {
                     auto canonical_rrset = canonical_node->find( qtype );
                     if ( canonical_rrset ) {
                         addRRSet( response.mAnswerSection, *canonical_rrset );
 			addRRSIG( response, response.mAnswerSection, *canonical_rrset );
                     }
                 }
-                return response;
+                return;
             }
 
 	    if ( qtype == TYPE_ANY ) {
@@ -147,7 +167,7 @@ namespace dns
 		    // NoData ( found empty non-terminal )
 		    responseNoData( qname, response, false );
 		}
-		return response;
+		return;
 	    }
 
             auto rrset = node->find( qtype );
@@ -156,35 +176,92 @@ namespace dns
                 response.mResponseCode = NO_ERROR;
                 addRRSet( response.mAnswerSection, *rrset );
 		addRRSIG( response, response.mAnswerSection, *rrset );
-                return response;
+                return;
             }
             else {
                 // NoData ( found empty non-terminal or other type )
 		responseNoData( qname, response, node->exist() );
-		return response;
+		return;
             }
         }
 
         // find NS + and DS for delegation
-        for ( auto parent = qname ; parent != mApex ; parent.popSubdomain() ) {
-            auto rrset = findRRSet( parent, TYPE_NS );
-            if ( rrset ) {
-                responseDelegation( qname, response, *rrset );
-                return response;
-            }
+        if ( result.mDelegation ) {
+            responseDelegation( qname, response, *result.mDelegation->second->find( TYPE_NS ) );
+            return;
         }
 
         // find DNAME
-        for ( auto parent_name = qname ; parent_name != mApex ; parent_name.popSubdomain() ) {
-            auto dname_rrset = findRRSet( parent_name, TYPE_DNAME );
+        if ( result.mDNAME ) {
+            const Domainname &parent_name = result.mDNAME->first;
+            auto dname_rrset = result.mDNAME->second->find( TYPE_DNAME );
+            if ( dname_rrset->count() != 1 )
+                throw std::logic_error( "multiple DNAME records exist " + parent_name.toString() );
+            response.mResponseCode = NO_ERROR;
+            addRRSet( response.mAnswerSection, *dname_rrset );
+		addRRSIG( response, response.mAnswerSection, *dname_rrset );
+
+            auto dname_rdata    = std::dynamic_pointer_cast<const RecordDNAME>( (*dname_rrset)[0] );
+            auto relative_name  = parent_name.getRelativeDomainname( qname );
+            auto canonical_name = relative_name + dname_rdata->getCanonicalName();
+            std::shared_ptr<RecordCNAME> cname_rdata( new RecordCNAME( canonical_name ) );
+            RRSet cname_rrset( canonical_name, dname_rrset->getClass(), TYPE_CNAME, dname_rrset->getTTL() );
+            cname_rrset.add( cname_rdata );
+
+            addRRSet( response.mAnswerSection, cname_rrset );
+		addRRSIG( response, response.mAnswerSection, cname_rrset );
+
+            auto canonical_node  = findNode( canonical_name );
+            if ( canonical_node ) {
+                auto canonical_rrset = canonical_node->find( qtype );
+                if ( canonical_rrset ) {
+                    addRRSet( response.mAnswerSection, *canonical_rrset );
+			addRRSIG( response, response.mAnswerSection, *canonical_rrset );
+                }
+            }
+            return;
+        }
+
+        // find wildcard
+        if ( result.mWildcard ) {
+            const Domainname &wildcard = result.mWildcard->first;
+            Domainname parent_name = wildcard;
+            parent_name.popSubdomain();
+
+            auto node = result.mWildcard->second;
+            auto cname_rrset = node->find( TYPE_CNAME );
+            if ( cname_rrset ) {
+                if ( cname_rrset->count() != 1 ) {
+                    throw std::logic_error( "muliple cname records exist in " + wildcard.toString() );
+                }
+            
+                // found
+                response.mResponseCode = NO_ERROR;
+                addRRSet( response.mAnswerSection, *cname_rrset, qname );
+                addRRSIG( response, response.mAnswerSection, *cname_rrset, qname );
+
+                RRSetPtr nsec = generateNSECRRSet( qname );
+                if ( nsec ) {
+                    addRRSet( response.mAuthoritySection, *nsec );
+                    addRRSIG( response, response.mAuthoritySection, *nsec );
+                }
+
+                return;
+            }
+
+            auto dname_rrset = node->find( TYPE_DNAME );
             if ( dname_rrset ) {
                 if ( dname_rrset->count() != 1 )
                     throw std::logic_error( "multiple DNAME records exist " + parent_name.toString() );
+
+                Domainname owner = parent_name;
+                owner.addSubdomain( qname.getLabel( qname.getLabelCount() - parent_name.getLabelCount() - 1 ) );
+
                 response.mResponseCode = NO_ERROR;
-                addRRSet( response.mAnswerSection, *dname_rrset );
-		addRRSIG( response, response.mAnswerSection, *dname_rrset );
+                addRRSet( response.mAnswerSection, *dname_rrset, owner );
+                addRRSIG( response, response.mAnswerSection, *dname_rrset, owner );
 
-                auto dname_rdata    = std::dynamic_pointer_cast<RecordDNAME>( (*dname_rrset)[0] );
+                auto dname_rdata    = std::dynamic_pointer_cast<const RecordDNAME>( (*dname_rrset)[0] );
                 auto relative_name  = parent_name.getRelativeDomainname( qname );
                 auto canonical_name = relative_name + dname_rdata->getCanonicalName();
                 std::shared_ptr<RecordCNAME> cname_rdata( new RecordCNAME( canonical_name ) );
@@ -192,131 +269,64 @@ namespace dns
                 cname_rrset.add( cname_rdata );
 
                 addRRSet( response.mAnswerSection, cname_rrset );
-		addRRSIG( response, response.mAnswerSection, cname_rrset );
+                addRRSIG( response, response.mAnswerSection, cname_rrset );
 
                 auto canonical_node  = findNode( canonical_name );
                 if ( canonical_node ) {
                     auto canonical_rrset = canonical_node->find( qtype );
                     if ( canonical_rrset ) {
                         addRRSet( response.mAnswerSection, *canonical_rrset );
-			addRRSIG( response, response.mAnswerSection, *canonical_rrset );
+                        addRRSIG( response, response.mAnswerSection, *canonical_rrset );
                     }
                 }
-                return response;
-            }   
-        }
 
-        // find wildcard
-        auto parent_name = qname;
-        while ( true ) {
-            if ( parent_name == mApex )
-                break;
-            parent_name.popSubdomain();
-            auto wildcard = parent_name;
-            wildcard.addSubdomain( "*" );
+                RRSetPtr nsec = generateNSECRRSet( owner );
+                if ( nsec ) {
+                    addRRSet( response.mAuthoritySection, *nsec );
+                    addRRSIG( response, response.mAuthoritySection, *nsec );
+                }
 
-            auto node = findNode( wildcard );
-            if ( node ) {
+                return;
+            }   
 
-                auto cname_rrset = node->find( TYPE_CNAME );
-                if ( cname_rrset ) {
-                    if ( cname_rrset->count() != 1 ) {
-                        throw std::logic_error( "muliple cname records exist in " + wildcard.toString() );
+            if ( qtype == TYPE_ANY ) {
+                if ( node->exist() ) {
+                    for ( auto rrset_itr = node->begin() ; rrset_itr != node->end() ; rrset_itr++ ) {
+                        auto rrset = *(rrset_itr->second);
+                        addRRSet( response.mAnswerSection, rrset, qname );
+                        addRRSIG( response, response.mAnswerSection, rrset, qname );
                     }
-                
-                    // found
-                    response.mResponseCode = NO_ERROR;
-                    addRRSet( response.mAnswerSection, *cname_rrset, qname );
-                    addRRSIG( response, response.mAnswerSection, *cname_rrset, qname );
 
                     RRSetPtr nsec = generateNSECRRSet( qname );
                     if ( nsec ) {
                         addRRSet( response.mAuthoritySection, *nsec );
                         addRRSIG( response, response.mAuthoritySection, *nsec );
                     }
-
-                    return response;
                 }
+                return;
+            }
 
-                auto dname_rrset = node->find( TYPE_DNAME );
-                if ( dname_rrset ) {
-                    if ( dname_rrset->count() != 1 )
-                        throw std::logic_error( "multiple DNAME records exist " + parent_name.toString() );
-
-                    Domainname owner = parent_name;
-                    owner.addSubdomain( qname.getLabels()[ qname.getLabelCount() - parent_name.getLabelCount() + 1 ] );
-
-                    response.mResponseCode = NO_ERROR;
-                    addRRSet( response.mAnswerSection, *dname_rrset, owner );
-                    addRRSIG( response, response.mAnswerSection, *dname_rrset, owner );
-
-                    auto dname_rdata    = std::dynamic_pointer_cast<RecordDNAME>( (*dname_rrset)[0] );
-                    auto relative_name  = parent_name.getRelativeDomainname( qname );
-                    auto canonical_name = relative_name + dname_rdata->getCanonicalName();
-                    std::shared_ptr<RecordCNAME> cname_rdata( new RecordCNAME( canonical_name ) );
-                    RRSet cname_rrset( canonical_name, dname_rrset->getClass(), TYPE_CNAME, dname_rrset->getTTL() );
-                    cname_rrset.add( cname_rdata );
-
-                    addRRSet( response.mAnswerSection, cname_rrset );
-                    addRRSIG( response, response.mAnswerSection, cname_rrset );
-
-                    auto canonical_node  = findNode( canonical_name );
-                    if ( canonical_node ) {
-                        auto canonical_rrset = canonical_node->find( qtype );
-                        if ( canonical_rrset ) {
-                            addRRSet( response.mAnswerSection, *canonical_rrset );
-                            addRRSIG( response, response.mAnswerSection, *canonical_rrset );
-                        }
-                    }
-
-                    RRSetPtr nsec = generateNSECRRSet( owner );
-                    if ( nsec ) {
-                        addRRSet( response.mAuthoritySection, *nsec );
-                        addRRSIG( response, response.mAuthoritySection, *nsec );
-                    }
+            auto rrset = node->find( qtype );
+            if ( rrset ) {
+                // found 
+                response.mResponseCode = NO_ERROR;
+                addRRSet( response.mAnswerSection, *rrset, qname );
+                addRRSIG( response, response.mAnswerSection, *rrset, qname );
 
-                    return response;
-                }   
-
-                if ( qtype == TYPE_ANY ) {
-                    if ( node->exist() ) {
-                        for ( auto rrset_itr = node->begin() ; rrset_itr != node->end() ; rrset_itr++ ) {
-                            auto rrset = *(rrset_itr->second);
-                            addRRSet( response.mAnswerSection, rrset, qname );
-                            addRRSIG( response, response.mAnswerSection, rrset, qname );
-                        }
-
-                        RRSetPtr nsec = generateNSECRRSet( qname );
-                        if ( nsec ) {
-                            addRRSet( response.mAuthoritySection, *nsec );
-                            addRRSIG( response, response.mAuthoritySection, *nsec );
-                        }
-                    }
-                    return response;
+                RRSetPtr nsec = generateNSECRRSet( qname );
+                if ( nsec ) {
+                    addRRSet( response.mAuthoritySection, *nsec );
+                    addRRSIG( response, response.mAuthoritySection, *nsec );
                 }
 
-                auto rrset = node->find( qtype );
-                if ( rrset ) {
-                    // found 
-                    response.mResponseCode = NO_ERROR;
-                    addRRSet( response.mAnswerSection, *rrset, qname );
-                    addRRSIG( response, response.mAnswerSection, *rrset, qname );
-
-                    RRSetPtr nsec = generateNSECRRSet( qname );
-                    if ( nsec ) {
-                        addRRSet( response.mAuthoritySection, *nsec );
-                        addRRSIG( response, response.mAuthoritySection, *nsec );
-                    }
-
-                    return response;
-                }
-            }   
+                return;
+            }
         }
 
 
         // NXDOMAIN
-	responseNXDomain( qname, response );
-        return response;
+	responseNXDomain( qname, response, result );
+        return;
     }
 
     std::vector<std::shared_ptr<RecordDS>> AbstractZoneImp::getDSRecords() const
@@ -334,11 +344,7 @@ namespace dns
 
     AbstractZoneImp::NodePtr AbstractZoneImp::findNode( const Domainname &name ) const
     {
-        auto node = mOwnerToNode.find( name );
-        if ( node != mOwnerToNode.end() ) {
-            return node->second;
-        }
-        return NodePtr();
+        return mNodes.find( name );
     }
 
     void AbstractZoneImp::addSOAToAuthoritySection( MessageInfo &response ) const
@@ -358,16 +364,8 @@ namespace dns
         response.mResponseCode        = NO_ERROR;
         response.mAuthoritativeAnswer = 0;
 
+        ns_rrset.addResourceRecords( response.mAuthoritySection );
         for ( auto ns : ns_rrset ) {
-            ResourceRecord rr;
-            rr.mDomainname = ns_rrset.getOwner();
-            rr.mClass      = ns_rrset.getClass();
-            rr.mType       = ns_rrset.getType();
-            rr.mTTL        = ns_rrset.getTTL();
-            rr.mRData      = ns;
-
-            response.pushAuthoritySection( rr );
-
             Domainname nameserver = dynamic_cast<const RecordNS &>( *ns ).getNameServer();
             auto glue_node = findNode( nameserver );
             if ( glue_node ) {
@@ -393,18 +391,13 @@ namespace dns
     {
         if ( owner == Domainname() )
             rrset.addResourceRecords( section );
-        else {
-            for ( auto rdata : rrset ) {
-                ResourceRecord rr;
-                rr.mDomainname = owner;
-                rr.mClass      = rrset.getClass();
-                rr.mType       = rrset.getType();
-                rr.mTTL        = rrset.getTTL();
-                rr.mRData      = rdata;
-
-                section.push_back( rr );
-            }
-        }
+        else
+            rrset.addResourceRecords( section, owner );
+    }
+
+    void AbstractZoneImp::enableResponseCache( unsigned int capacity )
+    {
+        mResponseCache.reset( new ResponseCache( capacity ) );
     }
 
     void AbstractZoneImp::verify() const
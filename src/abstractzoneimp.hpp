@@ -2,8 +2,10 @@
 #define ABSTRACT_ZONE_IMP_HPP
 
 #include "zone.hpp"
+#include "nodetree.hpp"
 #include "zonesigner.hpp"
 #include "nsecdb.hpp"
+#include "messageview.hpp"
 
 namespace dns
 {
@@ -12,20 +14,21 @@ namespace dns
     public:
         typedef std::shared_ptr<RRSet> RRSetPtr;
         typedef std::shared_ptr<Node>  NodePtr;
-	typedef std::map<Domainname,   NodePtr> OwnerToNodeContainer;
-	typedef std::pair<Domainname,  NodePtr> OwnerToNodePair;
 
     private:
-        OwnerToNodeContainer mOwnerToNode;
+        utils::ArenaPtr      mArena;
+        NodeTree             mNodes;
         Domainname           mApex;
 
         RRSetPtr mSOA;
         RRSetPtr mNameServers;
 
+        std::shared_ptr<ResponseCache> mResponseCache;
+
     protected:
-        void addEmptyNode( const Domainname & );
         void addRRSet( std::vector<ResourceRecord> &, const RRSet &rrset, const Domainname &owner = Domainname() ) const;
         void addSOAToAuthoritySection( MessageInfo &res ) const;
+        void getAnswer( const QuestionSectionEntry &question, MessageInfo &response ) const;
 
     public:
         AbstractZoneImp( const Domainname &zone_name );
@@ -36,23 +39,29 @@ namespace dns
 
         void add( RRSetPtr rrest );
         MessageInfo getAnswer( const MessageInfo &query ) const;
+        MessageInfo getAnswer( const MessageView &query ) const;
 	
         NodePtr  findNode( const Domainname &domainname ) const;
         RRSetPtr findRRSet( const Domainname &domainname, Type type ) const;
-        OwnerToNodeContainer::const_iterator begin() const { return mOwnerToNode.begin(); }
-        OwnerToNodeContainer::const_iterator end() const   { return mOwnerToNode.end(); }
+        NodeTree::LookupResult lookup( const Domainname &domainname ) const { return mNodes.lookup( domainname ); }
+        NodeTree::const_iterator begin() const { return mNodes.begin(); }
+        NodeTree::const_iterator end() const   { return mNodes.end(); }
 
         void verify() const;
 
+        void enableResponseCache( unsigned int capacity );
+        ResponseCache *getResponseCache() const { return mResponseCache.get(); }
+        utils::ArenaPtr getArena() const { return mArena; }
+
         virtual void setup() = 0;
 
 	virtual std::vector<std::shared_ptr<RecordDS>> getDSRecords() const = 0;
 	virtual std::shared_ptr<RRSet> signRRSet( const RRSet & ) const = 0;
 	virtual void responseDelegation( const Domainname &qname, MessageInfo &response, const RRSet &ns_rrset ) const;
 	virtual void responseNoData( const Domainname &qname, MessageInfo &response, bool need_wildcard_nsec ) const = 0;
-	virtual void responseNXDomain( const Domainname &qname, MessageInfo &response ) const = 0;
-	virtual void responseRRSIG( const Domainname &qname, MessageInfo &response ) const = 0;
-	virtual void responseNSEC( const Domainname &qname, MessageInfo &response ) const = 0;
+	virtual void responseNXDomain( const Domainname &qname, MessageInfo &response, const NodeTree::LookupResult &result ) const = 0;
+	virtual void responseRRSIG( const Domainname &qname, MessageInfo &response, const NodeTree::LookupResult &result ) const = 0;
+	virtual void responseNSEC( const Domainname &qname, MessageInfo &response, const NodeTree::LookupResult &result ) const = 0;
 	virtual void responseDNSKEY( const Domainname &qname, MessageInfo &response ) const = 0;
         virtual void addRRSIG( MessageInfo &, std::vector<ResourceRecord> &, const RRSet &original_rrset ) const = 0;
         virtual void addRRSIG( MessageInfo &, std::vector<ResourceRecord> &, const RRSet &original_rrset, const Domainname &owner ) const = 0;
@@ -0,0 +1,121 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <boost/noncopyable.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace utils
+{
+    /*!
+     * monotonic memory arena.
+     * Memory is carved from large blocks and never returned one by one; all blocks are freed
+     * at once when the arena is destroyed. It is not thread safe.
+     */
+    class Arena : private boost::noncopyable
+    {
+    public:
+        static const size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+        Arena( size_t block_size = DEFAULT_BLOCK_SIZE )
+            : mBlockSize( block_size ), mCurrent( nullptr ), mRemaining( 0 ), mAllocatedSize( 0 )
+        {}
+
+        /*!
+         * @param alignment power of 2, not greater than alignof( std::max_align_t ).
+         */
+        void *allocate( size_t size, size_t alignment = alignof( std::max_align_t ) )
+        {
+            size_t padding = ( alignment - reinterpret_cast<uintptr_t>( mCurrent ) % alignment ) % alignment;
+            if ( mCurrent == nullptr || padding + size > mRemaining ) {
+                // a large object gets its own block, so that the rest of current block is not wasted.
+                if ( size > mBlockSize / 4 ) {
+                    mBlocks.push_back( std::unique_ptr<uint8_t[]>( new uint8_t[ size ] ) );
+                    mAllocatedSize += size;
+                    return mBlocks.back().get();
+                }
+                mBlocks.push_back( std::unique_ptr<uint8_t[]>( new uint8_t[ mBlockSize ] ) );
+                mCurrent   = mBlocks.back().get();
+                mRemaining = mBlockSize;
+                padding    = 0;
+            }
+
+            void *p     = mCurrent + padding;
+            mCurrent   += padding + size;
+            mRemaining -= padding + size;
+            mAllocatedSize += size;
+            return p;
+        }
+
+        /*!
+         * @return total bytes handed out by allocate().
+         */
+        size_t getAllocatedSize() const { return mAllocatedSize; }
+        size_t getBlockCount() const    { return mBlocks.size(); }
+
+    private:
+        size_t                                  mBlockSize;
+        std::vector<std::unique_ptr<uint8_t[]>> mBlocks;
+        uint8_t                                *mCurrent;
+        size_t                                  mRemaining;
+        size_t                                  mAllocatedSize;
+    };
+
+    typedef std::shared_ptr<Arena> ArenaPtr;
+
+    /*!
+     * STL allocator over Arena. deallocate() does nothing.
+     * The allocator shares the arena, so that objects made by std::allocate_shared keep it alive
+     * after the owner of the arena is destroyed( e.g. RDATA copied into responses or caches ).
+     * Destructors of the objects still run one by one; only their memory is returned at once.
+     */
+    template <typename T>
+    class ArenaAllocator
+    {
+    public:
+        typedef T value_type;
+
+        template <typename U>
+        struct rebind {
+            typedef ArenaAllocator<U> other;
+        };
+
+        ArenaAllocator( const ArenaPtr &arena )
+            : mArena( arena )
+        {}
+
+        template <typename U>
+        ArenaAllocator( const ArenaAllocator<U> &other )
+            : mArena( other.getArena() )
+        {}
+
+        T *allocate( size_t n )
+        {
+            return static_cast<T *>( mArena->allocate( n * sizeof( T ), alignof( T ) ) );
+        }
+
+        void deallocate( T *, size_t ) {}
+
+        const ArenaPtr &getArena() const { return mArena; }
+
+    private:
+        ArenaPtr mArena;
+    };
+
+    template <typename T, typename U>
+    bool operator==( const ArenaAllocator<T> &lhs, const ArenaAllocator<U> &rhs )
+    {
+        return lhs.getArena() == rhs.getArena();
+    }
+
+    template <typename T, typename U>
+    bool operator!=( const ArenaAllocator<T> &lhs, const ArenaAllocator<U> &rhs )
+    {
+        return !( lhs == rhs );
+    }
+}
+
+#endif
@@ -17,6 +17,8 @@ namespace dns
 	}
         zone.reset( new UnsignedZone( Domainname( apex ) ) );
 	dns::full::load( *zone, Domainname( apex ), config );
+        if ( getServerParameters().mResponseCacheSize > 0 )
+            zone->enableResponseCache( getServerParameters().mResponseCacheSize );
     }
 
 
@@ -26,6 +28,19 @@ namespace dns
 	return modifyResponse( query, response, via_tcp );
     }
 
+    bool AuthServer::generateResponse( const dns::MessageView &query, bool via_tcp, dns::MessageInfo &response ) const
+    {
+	if ( hasModifyHooks() )
+	    return false;
+	response = zone->getAnswer( query );
+	return true;
+    }
+
+    ResponseCache *AuthServer::getResponseCache() const
+    {
+	return zone ? zone->getResponseCache() : nullptr;
+    }
+
     MessageInfo AuthServer::modifyResponse( const dns::MessageInfo &query,
 					    const dns::MessageInfo &original_response,
 					    bool via_tcp ) const
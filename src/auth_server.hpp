@@ -16,6 +16,13 @@ namespace dns
 
 	void load( const std::string &apex, const std::string &filename );
 	MessageInfo generateResponse( const MessageInfo &query, bool via_tcp ) const;
+
+        /*!
+         * answer from the zone without modifyResponse.
+         * It returns false if mModifyResponses is set, which a subclass overriding modifyResponse must set.
+         */
+	bool generateResponse( const MessageView &query, bool via_tcp, MessageInfo &response ) const;
+	ResponseCache *getResponseCache() const;
 	virtual MessageInfo modifyResponse( const MessageInfo &query,
 					    const MessageInfo &original_response,
 					    bool vir_tcp ) const;
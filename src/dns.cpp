@@ -62,8 +62,49 @@ namespace dns
 
 
     void MessageInfo::generateMessage( WireFormat &message ) const
+    {
+        generateMessage( message, 0xffff );
+    }
+
+    static bool isSameRRSet( const ResourceRecord &lhs, const ResourceRecord &rhs )
+    {
+        return lhs.mType == rhs.mType && lhs.mClass == rhs.mClass && lhs.mDomainname == rhs.mDomainname;
+    }
+
+    /*!
+     * write RRsets of the section while message size does not exceed end.
+     * @return count of written resource records.
+     */
+    static uint16_t generateSection( const std::vector<ResourceRecord> &section, WireFormat &message,
+                                     OffsetDB &offset_db, uint32_t end, bool &is_omitted )
+    {
+        uint16_t count = 0;
+        for ( auto rrset_begin = section.begin() ; rrset_begin != section.end() ; ) {
+            auto rrset_end = rrset_begin + 1;
+            while ( rrset_end != section.end() && isSameRRSet( *rrset_begin, *rrset_end ) )
+                ++rrset_end;
+
+            uint16_t        rrset_pos = message.size();
+            OffsetDB::State state     = offset_db.getState();
+            for ( auto rr = rrset_begin ; rr != rrset_end ; ++rr )
+                generateResourceRecord( *rr, message, offset_db );
+            if ( message.size() > end ) {
+                message.truncate( rrset_pos );
+                offset_db.restoreState( state );
+                is_omitted = true;
+                return count;
+            }
+
+            count      += rrset_end - rrset_begin;
+            rrset_begin = rrset_end;
+        }
+        return count;
+    }
+
+    bool MessageInfo::generateMessage( WireFormat &message, uint32_t max_size ) const
     {
         OffsetDB offset_db;
+        uint32_t begin = message.size();
 
         PacketHeaderField header;
         header.id                   = htons( mID );
@@ -78,32 +119,52 @@ namespace dns
         header.checking_disabled    = mCheckingDisabled;
         header.response_code        = mResponseCode;
 
-        std::vector<ResourceRecord> additional = mAdditionalSection;
-
-        if ( isEDNS0() ) {
-            additional.push_back( generateOptPseudoRecord( mOptPseudoRR ) );
-        }
-
         header.question_count              = htons( mQuestionSection.size() );
-        header.answer_count                = htons( mAnswerSection.size() );
-        header.authority_count             = htons( mAuthoritySection.size() );
-        header.additional_infomation_count = htons( additional.size() );
+        header.answer_count                = 0;
+        header.authority_count             = 0;
+        header.additional_infomation_count = 0;
 
+        // counts are fixed up after writing sections.
         message.pushBuffer( reinterpret_cast<const uint8_t *>( &header ),
                             reinterpret_cast<const uint8_t *>( &header ) + sizeof( header ) );
 
-        for ( auto q : mQuestionSection ) {
+        for ( auto &q : mQuestionSection ) {
             generateQuestion( q, message, offset_db );
         }
-        for ( auto q : mAnswerSection ) {
-            generateResourceRecord( q, message, offset_db );
-        }
-        for ( auto q : mAuthoritySection ) {
-            generateResourceRecord( q, message, offset_db );
+
+        // reserve space for OPT pseudo record, which must not be omitted.
+        ResourceRecord opt;
+        uint32_t       end = begin + max_size;
+        if ( isEDNS0() ) {
+            opt = generateOptPseudoRecord( mOptPseudoRR );
+            end = end > opt.size() ? end - opt.size() : 0;
         }
-        for ( auto q : additional ) {
-            generateResourceRecord( q, message, offset_db );
+
+        bool     is_truncated     = false;
+        bool     is_omitted       = false;
+        uint16_t answer_count     = 0;
+        uint16_t authority_count  = 0;
+        uint16_t additional_count = 0;
+
+        answer_count = generateSection( mAnswerSection, message, offset_db, end, is_truncated );
+        if ( ! is_truncated )
+            authority_count = generateSection( mAuthoritySection, message, offset_db, end, is_truncated );
+        if ( ! is_truncated )
+            additional_count = generateSection( mAdditionalSection, message, offset_db, end, is_omitted );
+        if ( isEDNS0() ) {
+            generateResourceRecord( opt, message, offset_db );
+            additional_count++;
         }
+
+        header.truncation                  = mTruncation || is_truncated;
+        header.answer_count                = htons( answer_count );
+        header.authority_count             = htons( authority_count );
+        header.additional_infomation_count = htons( additional_count );
+        const uint8_t *header_data = reinterpret_cast<const uint8_t *>( &header );
+        for ( unsigned int i = 0 ; i < sizeof( header ) ; i++ )
+            message[ begin + i ] = header_data[ i ];
+
+        return is_truncated;
     }
 
     uint32_t MessageInfo::getMessageSize() const
@@ -143,7 +204,13 @@ namespace dns
 
     void MessageInfo::addOption( std::shared_ptr<OptPseudoRROption> opt )
     {
-	std::dynamic_pointer_cast<RecordOptionsData>( mOptPseudoRR.mOptions )->add( opt );
+        // copy on write, because mOptions may be shared with other messages.
+        std::shared_ptr<RecordOptionsData> options( new RecordOptionsData );
+        auto current = std::dynamic_pointer_cast<const RecordOptionsData>( mOptPseudoRR.mOptions );
+        if ( current )
+            *options = *current;
+        options->add( opt );
+        mOptPseudoRR.mOptions = options;
     }
     
     MessageInfo parseDNSMessage( const uint8_t *begin, const uint8_t *end )
@@ -245,6 +312,42 @@ namespace dns
         return QuestionSectionEntryPair( question, pos );
     }
 
+    ConstWireRDataPtr compileRData( const RDATA &rdata )
+    {
+        std::shared_ptr<WireRData> wire_rdata( new WireRData );
+        WireFormat                 message;
+        OffsetDB                   recorder( wire_rdata->mNames );
+
+        rdata.outputWireFormat( message, recorder );
+        wire_rdata->mSource = &rdata;
+        wire_rdata->mData   = message.get();
+        return wire_rdata;
+    }
+
+    static void outputWireRData( const WireRData &rdata, WireFormat &message, OffsetDB &offset_db )
+    {
+        const uint8_t *data = rdata.mData.data();
+        if ( rdata.mNames.empty() ) {
+            message.pushUInt16HtoN( rdata.mData.size() );
+            message.pushBuffer( data, data + rdata.mData.size() );
+            return;
+        }
+
+        uint16_t rd_length_pos = message.size();
+        message.pushUInt16HtoN( 0 ); // write dummy data
+        uint32_t pos = 0;
+        for ( auto &name : rdata.mNames ) {
+            message.pushBuffer( data + pos, data + name.first );
+            offset_db.outputWireFormat( name.second, message );
+            pos = name.first + name.second.size();
+        }
+        message.pushBuffer( data + pos, data + rdata.mData.size() );
+
+        uint16_t rd_length = message.size() - rd_length_pos - 2;
+        message[rd_length_pos]   = ( 0xff00 & rd_length ) >> 8;
+        message[rd_length_pos+1] = ( 0x00ff & rd_length );
+    }
+
     void generateResourceRecord( const ResourceRecord &response, WireFormat &message, OffsetDB &offset_db, bool compression )
     {
         if ( compression )
@@ -254,7 +357,9 @@ namespace dns
         message.pushUInt16HtoN( response.mType );
         message.pushUInt16HtoN( response.mClass );
         message.pushUInt32HtoN( response.mTTL );
-        if ( response.mRData ) {
+        if ( compression && response.mWireRData && response.mWireRData->mSource == response.mRData.get() ) {
+            outputWireRData( *response.mWireRData, message, offset_db );
+        } else if ( response.mRData ) {
             uint32_t rdata_size = 0;
 	    uint16_t rd_length_pos = message.size();
             message.pushUInt16HtoN( 0 ); // write dummy data
@@ -2216,7 +2321,7 @@ namespace dns
         entry.mType       = TYPE_OPT;
         entry.mClass      = opt.mPayloadSize;
         entry.mTTL        = ( ( (uint32_t)opt.mRCode ) << 24 ) + ( opt.mDOBit ? ( (uint32_t)1 << 15 ) : 0 );
-        entry.mRData      = RDATAPtr( opt.mOptions->clone() );
+        entry.mRData      = opt.mOptions;
 
         return entry;
     }
@@ -2761,15 +2866,15 @@ namespace dns
         pos += sizeof( PacketHeaderField );
 
         // skip question section
-        for ( auto q : packet_info.mQuestionSection )
+        for ( size_t i = 0 ; i < packet_info.mQuestionSection.size() ; i++ )
             pos = parseQuestion( &hash_data[ 0 ], &hash_data[0] + hash_data.size(), pos ).second;
 
         // skip answer section
-        for ( auto r : packet_info.mAnswerSection )
+        for ( size_t i = 0 ; i < packet_info.mAnswerSection.size() ; i++ )
             pos = parseResourceRecord( &hash_data[ 0 ], &hash_data[0] + hash_data.size(), pos ).second;
 
         // skip authority section
-        for ( auto r : packet_info.mAuthoritySection )
+        for ( size_t i = 0 ; i < packet_info.mAuthoritySection.size() ; i++ )
             pos = parseResourceRecord( &hash_data[ 0 ], &hash_data[0] + hash_data.size(), pos ).second;
         // SKIP NON TSIG RECORD IN ADDITIONAL SECTION
         bool is_found_tsig = false;
@@ -1306,26 +1306,14 @@ namespace dns
         std::vector<OptPseudoRROptPtr> mOptions;
 
     public:
+        /*!
+         * options are shared with in_options, because they are not modified after construction.
+         */
         RecordOptionsData( const std::vector<OptPseudoRROptPtr> &in_options = std::vector<OptPseudoRROptPtr>() )
+            : mOptions( in_options )
         {
-	    for ( auto op : in_options )
-		mOptions.push_back( OptPseudoRROptPtr( op->clone() ) );
         }
 
-	RecordOptionsData( const RecordOptionsData &data )
-	{
-	    for ( auto op : data.getOptions() )
-		mOptions.push_back( OptPseudoRROptPtr( op->clone() ) );
-	}
-
-	RecordOptionsData &operator=( const RecordOptionsData &data )
-	{
-	    mOptions.clear();
-	    for ( auto op : data.getOptions() )
-		mOptions.push_back( OptPseudoRROptPtr( op->clone() ) );
-	    return *this;
-	}
-
 	void add( OptPseudoRROptPtr opt ) { mOptions.push_back( opt ); }
         virtual std::string toZone() const { return ""; }
         virtual std::string toString() const;
@@ -1359,7 +1347,7 @@ namespace dns
         uint8_t    mRCode;
         uint8_t    mVersion;
 	bool       mDOBit;
-        RDATAPtr   mOptions;
+        ConstRDATAPtr mOptions; // RecordOptionsData shared by copies
 
         OptPseudoRecord()
             : mDomainname( "." ),
@@ -1368,31 +1356,6 @@ namespace dns
               mDOBit(false),
               mOptions( RDATAPtr( new RecordOptionsData ) )
         {}
-
-	OptPseudoRecord( const OptPseudoRecord &opt ) :
-	    mDomainname( opt.mDomainname ),
-	    mPayloadSize( opt.mPayloadSize ),
-	    mRCode( opt.mRCode ),
-	    mVersion( opt.mVersion ),
-	    mDOBit( opt.mDOBit )
-        {
-	    if ( opt.mOptions )
-		mOptions = RDATAPtr( opt.mOptions->clone() );
-        }
-
-	OptPseudoRecord &operator=( const OptPseudoRecord &rhs )
-	{
-	    mDomainname  = rhs.mDomainname;
-	    mPayloadSize = rhs.mPayloadSize;
-	    mRCode       = rhs.mRCode;
-	    mVersion     = rhs.mVersion;
-	    mDOBit       = rhs.mDOBit;
-	    if ( rhs.mOptions )
-		mOptions = RDATAPtr( rhs.mOptions->clone() );
-	    else
-		mOptions = RDATAPtr( new RecordOptionsData );
-	    return *this;
-	}
     };
 
     class RecordTKEY : public RDATA
@@ -1552,12 +1515,29 @@ namespace dns
 	uint16_t size() const;
     };
 
+    /*!
+     * RDATA precompiled into uncompressed wire format.
+     * Names which can be compressed are kept with their offsets in mData, and only they are
+     * written through OffsetDB.
+     */
+    struct WireRData {
+        const RDATA          *mSource; // RDATA which this image is generated from
+        PacketData            mData;
+        OffsetDB::NameOffsets mNames;
+
+        WireRData() : mSource( nullptr ) {}
+    };
+    typedef std::shared_ptr<const WireRData> ConstWireRDataPtr;
+
+    ConstWireRDataPtr compileRData( const RDATA &rdata );
+
     struct ResourceRecord {
-        Domainname mDomainname;
-        uint16_t   mType;
-        uint16_t   mClass;
-        TTL        mTTL;
-        RDATAPtr   mRData;
+        Domainname        mDomainname;
+        uint16_t          mType;
+        uint16_t          mClass;
+        TTL               mTTL;
+        ConstRDATAPtr     mRData;     // shared by copies, because RDATA is immutable
+        ConstWireRDataPtr mWireRData; // precompiled mRData if it is in a zone
 
         ResourceRecord() 
             : mType( 0 ),
@@ -1567,30 +1547,6 @@ namespace dns
         }
 
     	uint32_t size() const;
-        
-	ResourceRecord( const ResourceRecord &entry )
-	    : mDomainname( entry.mDomainname ),
-	      mType( entry.mType ),
-	      mClass( entry.mClass ),
-	      mTTL( entry.mTTL )
-	{
-	    if ( entry.mRData )
-		mRData = RDATAPtr( entry.mRData->clone() );
-	}
-	
-	ResourceRecord &operator=( const ResourceRecord &rhs )
-	{
-	    mDomainname = rhs.mDomainname;
-	    mType       = rhs.mType;
-	    mClass      = rhs.mClass;
-	    mTTL        = rhs.mTTL;
-	    if ( rhs.mRData )
-		mRData = RDATAPtr( rhs.mRData->clone() );
-	    else
-		mRData = RDATAPtr();
-	    
-	    return *this;
-	}
     };
 
     struct MessageInfo {
@@ -1666,6 +1622,15 @@ namespace dns
         void clearAdditionalSection() { return mAdditionalSection.clear(); }
 
         void generateMessage( WireFormat & ) const;
+
+        /*!
+         * generate message in one pass, without exceeding max_size bytes.
+         * RRsets are written until one does not fit. If an RRset of answer or authority section is omitted,
+         * TC bit is set and following sections are omitted. Omitted RRsets of additional section do not set TC bit.
+         * OPT pseudo record is always written.
+         * @return true if TC bit is set by truncation.
+         */
+        bool generateMessage( WireFormat &, uint32_t max_size ) const;
         uint32_t getMessageSize() const;
     };
 
@@ -4,9 +4,11 @@
 #include <boost/cstdint.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/numeric/conversion/cast.hpp>
+#include <boost/optional.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/asio.hpp>
 #include <boost/bind.hpp>
+#include <algorithm>
 #include <iostream>
 #include <signal.h>
 #include <stdexcept>
@@ -14,6 +16,19 @@
 
 namespace dns
 {
+    OverloadPolicy stringToOverloadPolicy( const std::string &name )
+    {
+        if ( name == "drop-newest" )
+            return OVERLOAD_DROP_NEWEST;
+        if ( name == "drop-oldest" )
+            return OVERLOAD_DROP_OLDEST;
+        if ( name == "refused" )
+            return OVERLOAD_REFUSED;
+        if ( name == "truncate" )
+            return OVERLOAD_TRUNCATE;
+        throw std::runtime_error( "unknown overload policy \"" + name + "\"" );
+    }
+
     void DNSServer::addTSIGKey( const std::string &name, const TSIGKey &key )
     {
         mNameToKey.insert( std::pair<std::string, TSIGKey>( name, key ) );
@@ -78,8 +93,22 @@ namespace dns
         return response;
     }
     
+    utils::ThreadPoolPtr DNSServer::createThreadPool() const
+    {
+        if ( mServerParameters.mWorkStealing )
+            return utils::ThreadPoolPtr( new utils::WorkStealingThreadPool( mServerParameters.mThreadCount,
+                                                                            utils::DEFAULT_THREAD_POOL_QUEUE_SIZE,
+                                                                            mServerParameters.mCPUAffinity ) );
+        return utils::ThreadPoolPtr( new utils::ThreadPool( mServerParameters.mThreadCount ) );
+    }
+
     void DNSServer::startUDPServer()
     {
+        if ( mServerParameters.mUDPReusePort ) {
+            startReusePortUDPServer();
+            return;
+        }
+
         try {
             udpv4::ServerParameters params;
             params.mAddress   = mServerParameters.mBindAddress;
@@ -87,85 +116,265 @@ namespace dns
             params.mMulticast = mServerParameters.mMulticast;
             udpv4::Server dns_receiver( params );
 
-            utils::ThreadPool pool( mServerParameters.mThreadCount );
-            pool.start();
+            // buffers are queued up to mUDPQueueSize, and owned by workers until they send responses.
+            // when all buffers are used, received queries are shed by mUDPOverloadPolicy.
+            unsigned int queue_size = std::max( mServerParameters.mUDPQueueSize, 1u );
+            udpv4::ReceiveBufferPool buffers( queue_size + mServerParameters.mThreadCount, mServerParameters.mUDPBatchSize,
+                                              udpv4::DNS_QUERY_BUFFER_SIZE );
+            udpv4::ReceiveBuffer     overflow( mServerParameters.mUDPBatchSize, udpv4::DNS_QUERY_BUFFER_SIZE );
+            utils::MPMCQueue<udpv4::ReceiveBuffer *> queue( queue_size + mServerParameters.mThreadCount );
+            utils::ThreadPoolPtr pool = createThreadPool();
+            pool->start();
 
             while ( true ) {
-                udpv4::PacketInfo request = dns_receiver.receivePacket();
-                pool.submit( boost::bind( &DNSServer::replyOverUDP, this, boost::ref( dns_receiver ), request ) );
+                udpv4::ReceiveBuffer *requests = buffers.tryAcquire();
+                if ( requests == NULL ) {
+                    if ( mServerParameters.mUDPOverloadPolicy == OVERLOAD_DROP_OLDEST ) {
+                        if ( queue.pop( requests ) )
+                            mDroppedOldestCount += requests->size();
+                        else
+                            requests = buffers.acquire();
+                    }
+                    else {
+                        if ( dns_receiver.receivePackets( overflow ) == 0 )
+                            continue;
+                        mReceivedCount += overflow.size();
+                        replyOverloadResponses( dns_receiver, overflow );
+                        continue;
+                    }
+                }
+
+                if ( dns_receiver.receivePackets( *requests ) == 0 ) {
+                    buffers.release( requests );
+                    continue;
+                }
+                mReceivedCount += requests->size();
+                queue.push( requests );
+                pool->submit( boost::bind( &DNSServer::replyQueuedUDPQueries, this,
+                                           boost::ref( dns_receiver ), boost::ref( queue ), boost::ref( buffers ) ) );
             }
 
-            pool.join();
+            pool->join();
+
+        } catch ( std::runtime_error &e ) {
+	    BOOST_LOG_TRIVIAL(error) << "dns.server.udp: exception: " << e.what();
+        }
+    }
+
+    void DNSServer::startReusePortUDPServer()
+    {
+        udpv4::ServerParameters params;
+        params.mAddress   = mServerParameters.mBindAddress;
+        params.mPort      = mServerParameters.mBindPort;
+        params.mMulticast = mServerParameters.mMulticast;
+        params.mReusePort = true;
+
+        boost::thread_group workers;
+        for ( unsigned int i = 0 ; i < mServerParameters.mThreadCount ; i++ ) {
+            workers.create_thread( boost::bind( &DNSServer::runUDPWorker, this, params ) );
+        }
+        workers.join_all();
+    }
+
+    void DNSServer::runUDPWorker( const udpv4::ServerParameters &params )
+    {
+        try {
+            udpv4::Server        dns_receiver( params );
+            udpv4::ReceiveBuffer requests( mServerParameters.mUDPBatchSize, udpv4::DNS_QUERY_BUFFER_SIZE );
 
+            while ( true ) {
+                if ( dns_receiver.receivePackets( requests ) == 0 )
+                    continue;
+                mReceivedCount += requests.size();
+                replyOverUDP( dns_receiver, requests );
+            }
         } catch ( std::runtime_error &e ) {
 	    BOOST_LOG_TRIVIAL(error) << "dns.server.udp: exception: " << e.what();
         }
     }
 
-    void DNSServer::replyOverUDP( udpv4::Server &dns_receiver, udpv4::PacketInfo recv_data )
+    void DNSServer::replyQueuedUDPQueries( udpv4::Server &dns_receiver,
+                                           utils::MPMCQueue<udpv4::ReceiveBuffer *> &queue,
+                                           udpv4::ReceiveBufferPool &pool )
+    {
+        // the queries may have been dropped by OVERLOAD_DROP_OLDEST already.
+        udpv4::ReceiveBuffer *recv_data;
+        if ( ! queue.pop( recv_data ) )
+            return;
+        replyOverUDP( dns_receiver, *recv_data );
+        pool.release( recv_data );
+    }
+
+    /*!
+     * generate REFUSED or TC=1 response from the header and the question of the query without parsing it.
+     */
+    static bool generateOverloadResponse( const udpv4::PacketView &query, bool is_truncation, WireFormat &response )
+    {
+        const uint8_t *begin = query.begin();
+        const uint8_t *end   = query.end();
+        if ( end - begin < 12 )
+            return false;
+        if ( begin[ 2 ] & 0x80 )
+            return false; // QR=1
+        uint16_t question_count = ( begin[ 4 ] << 8 ) + begin[ 5 ];
+
+        const uint8_t *question_end = begin + 12;
+        if ( question_count == 1 ) {
+            while ( question_end < end && *question_end != 0 ) {
+                if ( ( *question_end & 0xc0 ) != 0 )
+                    return false;
+                question_end += *question_end + 1;
+            }
+            question_end += 1 + 4; // root label, QTYPE and QCLASS
+            if ( question_end > end )
+                return false;
+        }
+        else {
+            question_count = 0;
+        }
+
+        const uint8_t flags1 = 0x80 | ( begin[ 2 ] & 0x79 ) | ( is_truncation ? 0x02 : 0 ); // QR, Opcode, RD, TC
+        const uint8_t flags2 = ( begin[ 3 ] & 0x10 ) | ( is_truncation ? NO_ERROR : REFUSED ); // CD, RCODE
+        response.clear();
+        response.pushUInt8( begin[ 0 ] );
+        response.pushUInt8( begin[ 1 ] );
+        response.pushUInt8( flags1 );
+        response.pushUInt8( flags2 );
+        response.pushUInt16HtoN( question_count );
+        response.pushUInt16HtoN( 0 );
+        response.pushUInt16HtoN( 0 );
+        response.pushUInt16HtoN( 0 );
+        response.pushBuffer( begin + 12, question_end );
+        return true;
+    }
+
+    void DNSServer::replyOverloadResponses( udpv4::Server &dns_receiver, const udpv4::ReceiveBuffer &recv_data )
+    {
+        if ( mServerParameters.mUDPOverloadPolicy != OVERLOAD_REFUSED &&
+             mServerParameters.mUDPOverloadPolicy != OVERLOAD_TRUNCATE ) {
+            mDroppedNewestCount += recv_data.size();
+            return;
+        }
+
+        bool is_truncation = mServerParameters.mUDPOverloadPolicy == OVERLOAD_TRUNCATE;
+        std::vector<udpv4::OutgoingPacket> responses( recv_data.size() );
+        unsigned int response_count = 0;
+        for ( unsigned int i = 0 ; i < recv_data.size() ; i++ ) {
+            if ( ! generateOverloadResponse( recv_data[ i ], is_truncation, responses[ i ].mPayload ) )
+                continue;
+            responses[ i ].mDestination = udpv4::ClientParameters( recv_data[ i ].mSource, recv_data[ i ].mSourceLength );
+            response_count++;
+        }
+        if ( is_truncation )
+            mTruncatedCount += response_count;
+        else
+            mRefusedCount += response_count;
+        mDroppedNewestCount += recv_data.size() - response_count;
+
+        try {
+            dns_receiver.sendPackets( responses );
+        }
+        catch ( std::runtime_error &e ) {
+	    BOOST_LOG_TRIVIAL(error) << "dns.server.udp: send overload responses failed(" << e.what() << ").";
+        }
+    }
+
+    OverloadStatistics DNSServer::getOverloadStatistics() const
+    {
+        OverloadStatistics statistics;
+        statistics.mReceived      = mReceivedCount;
+        statistics.mDroppedNewest = mDroppedNewestCount;
+        statistics.mDroppedOldest = mDroppedOldestCount;
+        statistics.mRefused       = mRefusedCount;
+        statistics.mTruncated     = mTruncatedCount;
+        return statistics;
+    }
+
+    void DNSServer::replyOverUDP( udpv4::Server &dns_receiver, const udpv4::ReceiveBuffer &recv_data )
+    {
+        std::vector<udpv4::OutgoingPacket> responses( recv_data.size() );
+        for ( unsigned int i = 0 ; i < recv_data.size() ; i++ )
+            generateUDPResponse( recv_data[i], responses[i] );
+
+        try {
+            dns_receiver.sendPackets( responses );
+            BOOST_LOG_TRIVIAL(trace) << "dns.server.udp: sent " << responses.size() << " DNS messages.";
+        }
+        catch ( std::runtime_error &e ) {
+	    BOOST_LOG_TRIVIAL(error) << "dns.server.udp: send responses failed(" << e.what() << ").";
+        }
+    }
+
+    bool DNSServer::generateUDPResponse( const udpv4::PacketView &recv_data, udpv4::OutgoingPacket &response )
     {
         try {
 	    BOOST_LOG_TRIVIAL(trace) << "dns.server.udp: received DNS message from "
-				     << recv_data.mSourceAddress << ":" << recv_data.mSourcePort << ".";
+				     << recv_data.getSourceAddress() << ":" << recv_data.getSourcePort() << ".";
 	    
             MessageInfo query;
+            MessageInfo response_info;
+            bool        is_parsed = false;
+            uint32_t    requested_max_payload_size = 512;
+            ResponseCache *cache = nullptr;
+            boost::optional<MessageView> query_view;
 	    try {
-		query = parseDNSMessage( recv_data.begin(), recv_data.end() );
+                query_view.emplace( recv_data.begin(), recv_data.end() );
+                if ( query_view->isEDNS0() && query_view->getPayloadSize() > 512 )
+                    requested_max_payload_size = query_view->getPayloadSize();
+
+                // responses modified by modifyResponse or modifyMessage need the parsed query, and must not be cached.
+                bool use_view = ! hasModifyHooks() && ! query_view->isTSIG();
+                if ( use_view )
+                    cache = getResponseCache();
+                if ( cache && cache->find( *query_view, response.mPayload ) ) {
+                    BOOST_LOG_TRIVIAL(trace) << "dns.server.udp: response from cache";
+                    response.mDestination = udpv4::ClientParameters( recv_data.mSource, recv_data.mSourceLength );
+                    return true;
+                }
+
+                if ( ! use_view || ! generateResponse( *query_view, false, response_info ) ) {
+                    query     = query_view->getMessageInfo();
+                    is_parsed = true;
+                }
 	    }
 	    catch ( FormatError &e ) {
 		BOOST_LOG_TRIVIAL(info) << "dns.server.udp: " << "cannot parse query";
-		return;
+		return false;
 	    }
 
-	    BOOST_LOG_TRIVIAL(trace) << "dns.server.udp: " << "Query: " << query; 
+            if ( is_parsed ) {
+                BOOST_LOG_TRIVIAL(trace) << "dns.server.udp: " << "Query: " << query; 
 
-            if ( query.mIsTSIG ) {
-                ResponseCode rcode = verifyTSIGQuery( query, recv_data.begin(), recv_data.end() );
-                if ( rcode != NO_ERROR ) {
-                    MessageInfo response_info = generateTSIGErrorResponse( query, rcode );
+                if ( query.mIsTSIG ) {
+                    ResponseCode rcode = verifyTSIGQuery( query, recv_data.begin(), recv_data.end() );
+                    if ( rcode != NO_ERROR ) {
+                        MessageInfo response_info = generateTSIGErrorResponse( query, rcode );
+                    }
                 }
-            }
-
-            MessageInfo response_info = generateResponse( query, false );
-
-            BOOST_LOG_TRIVIAL(trace) << "dns.server.udp: Response: " << response_info;
 
-            uint32_t requested_max_payload_size = 512;
-            if ( query.isEDNS0() &&
-                 query.mOptPseudoRR.mPayloadSize > 512 ) {
-                requested_max_payload_size = query.mOptPseudoRR.mPayloadSize;
-                if ( query.mOptPseudoRR.mPayloadSize > 4096 )
-                    query.mOptPseudoRR.mPayloadSize = 4096;
+                response_info = generateResponse( query, false );
             }
 
-            BOOST_LOG_TRIVIAL(trace) << "dns.server.udp: response size(UDP): " << response_info.getMessageSize();
-            if ( response_info.getMessageSize() > requested_max_payload_size ) {
-                BOOST_LOG_TRIVIAL(trace) << "dns.server.udp: response TC=1: " << response_info.getMessageSize();
-                response_info.mTruncation = 1;
-                            
-                response_info.clearAnswerSection();
-                response_info.clearAuthoritySection();
-                response_info.clearAdditionalSection();
-            }
+            BOOST_LOG_TRIVIAL(trace) << "dns.server.udp: Response: " << response_info;
 
-            WireFormat response_packet;
-            response_info.generateMessage( response_packet );
+            if ( response_info.generateMessage( response.mPayload, requested_max_payload_size ) )
+                BOOST_LOG_TRIVIAL(trace) << "dns.server.udp: response TC=1: " << response.mPayload.size();
+            BOOST_LOG_TRIVIAL(trace) << "dns.server.udp: response size(UDP): " << response.mPayload.size();
 
-            modifyMessage( query, response_packet );
+            if ( is_parsed )
+                modifyMessage( query, response.mPayload );
+            else if ( cache )
+                cache->insert( *query_view, response.mPayload );
 		    
-            udpv4::ClientParameters client;
-            client.mAddress = recv_data.mSourceAddress;
-            client.mPort    = recv_data.mSourcePort;
-            dns_receiver.sendPacket( client, response_packet );
-
-	    BOOST_LOG_TRIVIAL(trace) << "dns.server.udp: sent DNS message to "
-				     << client.mAddress << ":" << client.mPort << ".";
+            response.mDestination = udpv4::ClientParameters( recv_data.mSource, recv_data.mSourceLength );
+            return true;
         }
         catch ( std::runtime_error &e ) {
-	    BOOST_LOG_TRIVIAL(error) << "dns.server.udp: recv/send response failed(" << e.what() << ") from "
-				     << recv_data.mSourceAddress << ":" << recv_data.mSourcePort << ".";
+	    BOOST_LOG_TRIVIAL(error) << "dns.server.udp: generating response failed(" << e.what() << ") from "
+				     << recv_data.getSourceAddress() << ":" << recv_data.getSourcePort() << ".";
+            response.mPayload.clear();
         }
-
+        return false;
     }
 
     void DNSServer::sendZone( const MessageInfo &query, tcpv4::ConnectionPtr &connection )
@@ -181,52 +390,57 @@ namespace dns
             params.mPort    = mServerParameters.mBindPort;
             tcpv4::Server dns_receiver( params );
 
-            while ( true ) {
+            utils::ThreadPoolPtr pool = createThreadPool();
+            pool->start();
 
-                try {
-                    tcpv4::ConnectionPtr connection = dns_receiver.acceptConnection();
-                    boost::thread tcp_thread( &DNSServer::replyOverTCP, this, connection );
-                    tcp_thread.detach();
-                }
-                catch ( std::runtime_error &e ) {
-                    BOOST_LOG_TRIVIAL(error) << "dns,server.tcp: recv/send response failed(" << e.what() << ").";
-                }
-            }
+            // epoll loop owns all connections, and workers generate responses.
+            // connections are kept until idle timeout for pipelined queries(RFC 7766).
+            tcpv4::EventLoopParameters loop_params;
+            loop_params.mIdleTimeout = mServerParameters.mTCPIdleTimeout;
+            tcpv4::EventLoop loop( dns_receiver,
+                                   boost::bind( &DNSServer::dispatchTCPQuery, this, boost::ref( *pool ), _1, _2, _3 ),
+                                   loop_params );
+            loop.run();
+
+            pool->join();
         }
         catch ( std::runtime_error &e ) {
 	    BOOST_LOG_TRIVIAL(error) << "dns.server.tcp: exception: " << e.what() << std::endl;
         }
     }
 
+    bool DNSServer::dispatchTCPQuery( utils::AbstractThreadPool &pool, tcpv4::EventLoop &loop,
+                                      tcpv4::ConnectionID id, const PacketData &recv_data )
+    {
+        // the event loop must not block, because zone transfers in workers wait for it in detachConnection.
+        return pool.trySubmit( boost::bind( &DNSServer::replyOverTCP, this, boost::ref( loop ), id, recv_data ) );
+    }
 
-    void DNSServer::replyOverTCP( tcpv4::ConnectionPtr connection )
+    void DNSServer::replyOverTCP( tcpv4::EventLoop &loop, tcpv4::ConnectionID id, const PacketData &recv_data )
     {
         try {
-	    BOOST_LOG_TRIVIAL(trace) << "dns.server.tcp: connected.";
-
-            PacketData size_data = connection->receive( 2 );
-            if ( size_data.size() < 2 ) {
-                throw std::runtime_error( "cannot get size of dns message" );
-            }
-            uint16_t size = ntohs( *( reinterpret_cast<const uint16_t *>( &size_data[ 0 ] ) ) );
-	    BOOST_LOG_TRIVIAL(trace) << "dns.server.tcp: message size: " << size;
+	    BOOST_LOG_TRIVIAL(trace) << "dns.server.tcp: message size: " << recv_data.size();
 
-            PacketData  recv_data = connection->receive( size );
 	    MessageInfo query;
 	    try {
-		query = parseDNSMessage( &recv_data[ 0 ], &recv_data[ 0 ] + recv_data.size() );
+		query = parseDNSMessage( recv_data.data(), recv_data.data() + recv_data.size() );
 	    }
 	    catch ( FormatError &e ) {
 		BOOST_LOG_TRIVIAL(info) << "dns.server.tcp: cannot parse DNS query message( " << e.what() << " ).";
+		loop.closeConnection( id );
 		return;
 	    }
 		
 	    BOOST_LOG_TRIVIAL(trace) << "dns.server.tcp: query: " << query;
 
-            if ( query.mQuestionSection[ 0 ].mType == dns::TYPE_AXFR ||
-                 query.mQuestionSection[ 0 ].mType == dns::TYPE_IXFR ) {
+            if ( query.mQuestionSection.size() > 0 &&
+                 ( query.mQuestionSection[ 0 ].mType == dns::TYPE_AXFR ||
+                   query.mQuestionSection[ 0 ].mType == dns::TYPE_IXFR ) ) {
 		BOOST_LOG_TRIVIAL(debug) << "dns.server.tcp: sending zone";
-                sendZone( query, connection );
+                // zone transfer writes many messages, so it uses the connection in blocking mode.
+                tcpv4::ConnectionPtr connection = loop.detachConnection( id );
+                if ( connection )
+                    sendZone( query, connection );
             }
             else {
                 MessageInfo response_info = generateResponse( query, true );
@@ -243,15 +457,15 @@ namespace dns
                 response_info.generateMessage( response_stream );
 		BOOST_LOG_TRIVIAL(trace) << "dns.server.tcp: generated DNS Message.";
                 modifyMessage( query, response_stream );
-			
-                uint16_t send_size = htons( response_stream.size() );
-                connection->send( reinterpret_cast<const uint8_t *>( &send_size ), sizeof( send_size ) );
-                connection->send( response_stream );
+
+                // send the response as soon as it is ready, even if it overtakes earlier queries.
+                loop.sendMessage( id, response_stream );
             }
 	    BOOST_LOG_TRIVIAL(debug) << "dns.server.tcp: sent response.";
         } 
         catch ( std::runtime_error &e ) {
 	    BOOST_LOG_TRIVIAL(error) << "dns.server.tcp: recv/send response failed(" << e.what() << ").";
+            loop.closeConnection( id );
         }
     }
 
@@ -2,11 +2,15 @@
 #define DNS_SERVER_HPP
 
 #include "dns.hpp"
+#include "messageview.hpp"
+#include "responsecache.hpp"
 #include "tcpv4server.hpp"
+#include "tcpv4eventloop.hpp"
 #include "udpv4server.hpp"
 #include "wireformat.hpp"
 #include "threadpool.hpp"
 #include <boost/thread.hpp>
+#include <atomic>
 #include <map>
 #include <string>
 
@@ -28,19 +32,64 @@ namespace dns
         {}
     };
 
+    /*!
+     * how the UDP server sheds queries when workers cannot keep up.
+     */
+    enum OverloadPolicy {
+        OVERLOAD_DROP_NEWEST, // drop received queries
+        OVERLOAD_DROP_OLDEST, // drop the oldest queued queries
+        OVERLOAD_REFUSED,     // answer REFUSED without generateResponse
+        OVERLOAD_TRUNCATE,    // answer TC=1 without generateResponse
+    };
+
+    /*!
+     * @param name "drop-newest", "drop-oldest", "refused" or "truncate"
+     */
+    OverloadPolicy stringToOverloadPolicy( const std::string &name );
+
+    struct OverloadStatistics {
+        uint64_t mReceived;
+        uint64_t mDroppedNewest;
+        uint64_t mDroppedOldest;
+        uint64_t mRefused;
+        uint64_t mTruncated;
+    };
+
     struct DNSServerParameters {
 	std::string  mBindAddress;
 	uint16_t     mBindPort;
 	bool         mMulticast;
 	bool         mDebug;
 	unsigned int mThreadCount;
+	unsigned int mUDPBatchSize;
+	bool         mUDPReusePort;
+	unsigned int mTCPIdleTimeout;
+	bool         mWorkStealing;
+	bool         mCPUAffinity;
+	unsigned int mUDPQueueSize;            // count of queued batches, unused with mUDPReusePort
+	OverloadPolicy mUDPOverloadPolicy;
+	unsigned int mResponseCacheSize;       // count of cached UDP responses, 0 disables the cache
+	unsigned int mSignatureCacheSize;      // count of cached RRSIGs of signed zones, 0 disables the cache
+	bool         mPresignZone;             // sign all RRSets of signed zones at loading
+	bool         mModifyResponses;         // responses are changed by modifyResponse or modifyMessage
 
 	DNSServerParameters()
 	    : mBindAddress( "0.0.0.0" ),
 	      mBindPort( 53 ),
 	      mMulticast( false ),
 	      mDebug( false ),
-	      mThreadCount( 1 )
+	      mThreadCount( 1 ),
+	      mUDPBatchSize( udpv4::DEFAULT_BATCH_SIZE ),
+	      mUDPReusePort( false ),
+	      mTCPIdleTimeout( 10 ),
+	      mWorkStealing( false ),
+	      mCPUAffinity( false ),
+	      mUDPQueueSize( 64 ),
+	      mUDPOverloadPolicy( OVERLOAD_DROP_NEWEST ),
+	      mResponseCacheSize( 0 ),
+	      mSignatureCacheSize( 4096 ),
+	      mPresignZone( false ),
+	      mModifyResponses( false )
 	{}
     };
 
@@ -51,31 +100,88 @@ namespace dns
         bool                           mDebug;
         std::map<std::string, TSIGKey> mNameToKey;
 
+        std::atomic<uint64_t> mReceivedCount;
+        std::atomic<uint64_t> mDroppedNewestCount;
+        std::atomic<uint64_t> mDroppedOldestCount;
+        std::atomic<uint64_t> mRefusedCount;
+        std::atomic<uint64_t> mTruncatedCount;
+
+        utils::ThreadPoolPtr createThreadPool() const;
         void startUDPServer();
-        void replyOverUDP( udpv4::Server &server, udpv4::PacketInfo );
+        void startReusePortUDPServer();
+        void runUDPWorker( const udpv4::ServerParameters &params );
+        void replyOverUDP( udpv4::Server &server, const udpv4::ReceiveBuffer &recv_data );
+        void replyQueuedUDPQueries( udpv4::Server &server,
+                                    utils::MPMCQueue<udpv4::ReceiveBuffer *> &queue,
+                                    udpv4::ReceiveBufferPool &pool );
+        void replyOverloadResponses( udpv4::Server &server, const udpv4::ReceiveBuffer &recv_data );
+        bool generateUDPResponse( const udpv4::PacketView &recv_data, udpv4::OutgoingPacket &response );
         void startTCPServer();
-        void replyOverTCP( tcpv4::ConnectionPtr connection );
+        bool dispatchTCPQuery( utils::AbstractThreadPool &pool, tcpv4::EventLoop &loop,
+                               tcpv4::ConnectionID id, const PacketData &recv_data );
+        void replyOverTCP( tcpv4::EventLoop &loop, tcpv4::ConnectionID id, const PacketData &recv_data );
 
         ResponseCode verifyTSIGQuery( const MessageInfo &query, const uint8_t *begin, const uint8_t *end ) const;
         MessageInfo generateTSIGErrorResponse( const MessageInfo &query, ResponseCode rcode ) const;
 	MessageInfo generateErrorResponse( const MessageInfo &query, ResponseCode rcode ) const;
         void sendZone( const MessageInfo &info, tcpv4::ConnectionPtr &connection );
         bool isDebug() const { return mDebug; }
+    protected:
+        const DNSServerParameters &getServerParameters() const { return mServerParameters; }
     public:
         DNSServer( const DNSServerParameters &params )
             : mServerParameters( params ),
-	      mDebug( params.mDebug )
+	      mDebug( params.mDebug ),
+	      mReceivedCount( 0 ),
+	      mDroppedNewestCount( 0 ),
+	      mDroppedOldestCount( 0 ),
+	      mRefusedCount( 0 ),
+	      mTruncatedCount( 0 )
         {}
 
         ~DNSServer()
         {}
 
         virtual MessageInfo generateResponse( const MessageInfo &query, bool via_tcp ) const = 0;
+
+        /*!
+         * generate response from the query view without parsing all sections of the query.
+         * It is not used if mModifyResponses is set.
+         * @return false if the server needs the parsed query. then generateResponse( MessageInfo ) and
+         *         modifyMessage are used.
+         */
+        virtual bool generateResponse( const MessageView &query, bool via_tcp, MessageInfo &response ) const
+        {
+            return false;
+        }
+
+        /*!
+         * @return true if the server declares mModifyResponses, so that responses need the parsed query
+         *         and are not cached.
+         */
+        bool hasModifyHooks() const
+        {
+            return mServerParameters.mModifyResponses;
+        }
+
+        /*!
+         * cache of UDP responses generated by generateResponse( MessageView ).
+         * @return NULL if the server does not cache responses.
+         */
+        virtual ResponseCache *getResponseCache() const
+        {
+            return nullptr;
+        }
         virtual void generateAXFRResponse( const MessageInfo &query, tcpv4::ConnectionPtr &conn ) const {}
 	virtual void modifyMessage( const MessageInfo &query, WireFormat &messge ) const {} 
         void start();
 
         void addTSIGKey( const std::string &name, const TSIGKey &key );
+
+        /*!
+         * @return count of UDP queries received and shed by mUDPOverloadPolicy.
+         */
+        OverloadStatistics getOverloadStatistics() const;
     };
 }
 
@@ -20,6 +20,10 @@ int main( int argc, char **argv )
     std::string nsec3_salt_str;
     uint16_t    nsec3_iterate;
     uint16_t    nsec3_hash_algo;
+    unsigned int udp_queue_size;
+    std::string overload_policy;
+    unsigned int response_cache_size;
+    unsigned int signature_cache_size;
 
     po::options_description desc( "dnssec server" );
     desc.add_options()( "help,h", "print this message" )
@@ -27,6 +31,14 @@ int main( int argc, char **argv )
         ( "bind,b",    po::value<std::string>( &bind_address )->default_value( "0.0.0.0" ), "bind address" )
         ( "port,p",    po::value<uint16_t>( &bind_port )->default_value( 53 ),              "bind port" )
         ( "thread,n",  po::value<uint16_t>( &thread_count )->default_value( 1 ),            "thread count" )
+        ( "reuseport",                                                                      "open SO_REUSEPORT UDP socket per thread" )
+        ( "work-stealing",                                                                  "use work-stealing thread pool" )
+        ( "cpu-affinity",                                                                   "bind worker threads to CPUs" )
+        ( "presign",                                                                        "sign all RRSets at loading" )
+        ( "udp-queue", po::value<unsigned int>( &udp_queue_size )->default_value( 64 ),     "count of queued UDP batches" )
+        ( "overload",  po::value<std::string>( &overload_policy )->default_value( "drop-newest" ), "drop-newest, drop-oldest, refused or truncate" )
+        ( "response-cache", po::value<unsigned int>( &response_cache_size )->default_value( 0 ), "count of cached UDP responses( 0: disabled )" )
+        ( "signature-cache", po::value<unsigned int>( &signature_cache_size )->default_value( 4096 ), "count of cached RRSIGs( 0: disabled )" )
 	( "file,f",    po::value<std::string>( &zone_filename ),                            "zone filename" )
 	( "zone,z",    po::value<std::string>( &apex),                                      "zone apex" )
         ( "ksk,K",     po::value<std::string>( &ksk_filename),                              "KSK filename" )
@@ -53,6 +65,14 @@ int main( int argc, char **argv )
 	params.mBindAddress = bind_address;
 	params.mBindPort    = bind_port;
 	params.mThreadCount = thread_count;
+	params.mUDPReusePort = vm.count( "reuseport" ) > 0;
+	params.mWorkStealing = vm.count( "work-stealing" ) > 0;
+	params.mCPUAffinity  = vm.count( "cpu-affinity" ) > 0;
+	params.mUDPQueueSize = udp_queue_size;
+	params.mUDPOverloadPolicy = dns::stringToOverloadPolicy( overload_policy );
+	params.mResponseCacheSize = response_cache_size;
+	params.mSignatureCacheSize = signature_cache_size;
+	params.mPresignZone = vm.count( "presign" ) > 0;
 	dns::SignedAuthServer server( params );
 	server.load( apex, zone_filename,
                      ksk_filename, zsk_filename,
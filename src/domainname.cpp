@@ -1,4 +1,5 @@
 #include "domainname.hpp"
+#include <algorithm>
 #include <iomanip>
 #include <cstring>
 #include <cctype>
@@ -15,14 +16,6 @@ namespace dns
         return c;
     }
 
-    static std::string toLowerLabel( const std::string &label )
-    {
-        std::string lower_label;
-        for ( unsigned int i = 0; i < label.size(); i++ )
-            lower_label.push_back( toLower( label[i] ) );
-        return lower_label;
-    }
-
     static void throwInvalidDomainnameString( const char *name )
     {
         std::ostringstream os;
@@ -84,120 +77,202 @@ namespace dns
             labels.push_back( label );
     }
 
-    static void canonicalizeLabels( const std::deque<std::string> &from,
-                                    std::deque<std::string> &to )
+    static void throwTooLongDomainname()
     {
-        to.clear();
-        for ( unsigned int i = 0; i < from.size(); i++ ) {
-            if ( from[ i ].size() == 0 )
-                break;
-            to.push_back( toLowerLabel( from[i] ) );
-        }
+        throw FormatError( "too long domainname" );
     }
 
-
-    static void outputWireFormat( const std::deque<std::string> labels,
-                                  PacketData &message, Offset offset )
+    static int compareLabel( const uint8_t *lhs, const uint8_t *rhs )
     {
-        for ( unsigned int i = 0; i < labels.size(); i++ ) {
-            if ( labels[ i ].size() == 0 )
-                break;
-            message.push_back( labels[ i ].size() );
-            for ( unsigned int j = 0; j < labels[ i ].size(); j++ )
-                message.push_back( labels[ i ][ j ] );
-        }
-
-        if ( offset == NO_COMPRESSION ) {
-            message.push_back( 0 );
-        } else {
-            message.push_back( 0xC0 | ( uint8_t )( offset >> 8 ) );
-            message.push_back( 0xff & (uint8_t)offset );
+        unsigned int lhs_length = *lhs++;
+        unsigned int rhs_length = *rhs++;
+        unsigned int length     = std::min( lhs_length, rhs_length );
+        for ( unsigned int i = 0 ; i < length ; i++ ) {
+            uint8_t l = toLower( lhs[i] );
+            uint8_t r = toLower( rhs[i] );
+            if ( l != r )
+                return l < r ? -1 : 1;
         }
+        if ( lhs_length == rhs_length )
+            return 0;
+        return lhs_length < rhs_length ? -1 : 1;
     }
 
-
-    static void outputWireFormat( const std::deque<std::string> labels,
-                                  WireFormat &message, Offset offset )
+    static bool equalIgnoreCase( const uint8_t *lhs, const uint8_t *rhs, unsigned int length )
     {
-        for ( unsigned int i = 0; i < labels.size(); i++ ) {
-            if ( labels[ i ].size() == 0 )
-                break;
-            message.push_back( labels[ i ].size() );
-            for ( unsigned int j = 0; j < labels[ i ].size(); j++ )
-                message.push_back( labels[ i ][ j ] );
-        }
-
-        if ( offset == NO_COMPRESSION ) {
-            message.push_back( 0 );
-        } else {
-            message.push_back( 0xC0 | ( uint8_t )( offset >> 8 ) );
-            message.push_back( 0xff & (uint8_t)offset );
+        for ( unsigned int i = 0 ; i < length ; i++ ) {
+            if ( lhs[i] != rhs[i] && toLower( lhs[i] ) != toLower( rhs[i] ) )
+                return false;
         }
+        return true;
     }
 
     Domainname::Domainname( const std::deque<std::string> &l )
-        : labels( l )
+        : mBegin( DATA_SIZE ), mFirstLabel( MAX_LABEL_COUNT )
     {
-        canonicalizeLabels( labels, canonical_labels );
+        for ( auto &label : l ) {
+            if ( label.size() == 0 )
+                break;
+            addSuffix( label );
+        }
     }
     
     Domainname::Domainname( const char *name )
+        : mBegin( DATA_SIZE ), mFirstLabel( MAX_LABEL_COUNT )
     {
+        std::deque<std::string> labels;
         stringToLabels( name, labels );
-        canonicalizeLabels( labels, canonical_labels );
+        for ( auto &label : labels )
+            addSuffix( label );
     }
 
     Domainname::Domainname( const std::string &name )
+        : mBegin( DATA_SIZE ), mFirstLabel( MAX_LABEL_COUNT )
     {
+        std::deque<std::string> labels;
         stringToLabels( name.c_str(), labels );
-        canonicalizeLabels( labels, canonical_labels );
+        for ( auto &label : labels )
+            addSuffix( label );
+    }
+
+    Domainname::Domainname( const Domainname &src )
+        : mBegin( src.mBegin ), mFirstLabel( src.mFirstLabel )
+    {
+        std::memcpy( mData + mBegin, src.mData + mBegin, DATA_SIZE - mBegin );
+        std::memcpy( mLabelOffsets + mFirstLabel, src.mLabelOffsets + mFirstLabel, MAX_LABEL_COUNT - mFirstLabel );
+    }
+
+    Domainname &Domainname::operator=( const Domainname &src )
+    {
+        mBegin      = src.mBegin;
+        mFirstLabel = src.mFirstLabel;
+        std::memmove( mData + mBegin, src.mData + mBegin, DATA_SIZE - mBegin );
+        std::memmove( mLabelOffsets + mFirstLabel, src.mLabelOffsets + mFirstLabel, MAX_LABEL_COUNT - mFirstLabel );
+        return *this;
+    }
+
+    void Domainname::prependWireFormat( const uint8_t *begin, const uint8_t *end )
+    {
+        unsigned int length = end - begin;
+        if ( length > mBegin )
+            throwTooLongDomainname();
+
+        uint8_t      offsets[ MAX_LABEL_COUNT ];
+        unsigned int label_count = 0;
+        uint8_t      new_begin   = mBegin - length;
+        for ( unsigned int pos = 0 ; pos < length ; pos += begin[ pos ] + 1 ) {
+            if ( begin[ pos ] > MAX_LABEL_LENGTH )
+                throw FormatError( "too long label" );
+            offsets[ label_count++ ] = new_begin + pos;
+        }
+        if ( label_count > mFirstLabel )
+            throwTooLongDomainname();
+
+        std::memcpy( mData + new_begin, begin, length );
+        mBegin       = new_begin;
+        mFirstLabel -= label_count;
+        std::memcpy( mLabelOffsets + mFirstLabel, offsets, label_count );
+    }
+
+    void Domainname::appendWireFormat( const uint8_t *begin, const uint8_t *end )
+    {
+        unsigned int length = end - begin;
+        if ( length > mBegin )
+            throwTooLongDomainname();
+
+        uint8_t      offsets[ MAX_LABEL_COUNT ];
+        unsigned int label_count = 0;
+        for ( unsigned int pos = 0 ; pos < length ; pos += begin[ pos ] + 1 ) {
+            if ( begin[ pos ] > MAX_LABEL_LENGTH )
+                throw FormatError( "too long label" );
+            offsets[ label_count++ ] = DATA_SIZE - length + pos;
+        }
+        if ( label_count > mFirstLabel )
+            throwTooLongDomainname();
+
+        // move current labels toward the head.
+        std::memmove( mData + mBegin - length, mData + mBegin, DATA_SIZE - mBegin );
+        std::memmove( mLabelOffsets + mFirstLabel - label_count, mLabelOffsets + mFirstLabel, MAX_LABEL_COUNT - mFirstLabel );
+        mBegin      -= length;
+        mFirstLabel -= label_count;
+        for ( unsigned int i = mFirstLabel ; i < MAX_LABEL_COUNT - label_count ; i++ )
+            mLabelOffsets[ i ] -= length;
+
+        std::memcpy( mData + DATA_SIZE - length, begin, length );
+        std::memcpy( mLabelOffsets + MAX_LABEL_COUNT - label_count, offsets, label_count );
+    }
+
+    void Domainname::outputLowerCase( uint8_t *buffer ) const
+    {
+        // label length bytes( <= 63 ) are not changed by toLower.
+        const uint8_t *data = getData();
+        for ( unsigned int i = 0 ; i < getDataLength() ; i++ )
+            buffer[ i ] = toLower( data[ i ] );
     }
 
     std::string Domainname::toString() const
     {
-        std::stringstream result;
-        for ( auto label : labels ) {
-            for ( uint8_t c : label ) {
-		result << c;
-            }
-            result << '.';
+        std::string result;
+        result.reserve( getDataLength() + 1 );
+        for ( unsigned int i = 0 ; i < getLabelCount() ; i++ ) {
+            const uint8_t *label = getLabelBegin( i );
+            result.append( reinterpret_cast<const char *>( label + 1 ), *label );
+            result.push_back( '.' );
         }
         
-        return result.str();
+        return result;
     }
 
     PacketData Domainname::getPacket( Offset offset ) const
     {
         PacketData bin;
-        dns::outputWireFormat( labels, bin, offset );
+        outputWireFormat( bin, offset );
         return bin;
     }
 
     void Domainname::outputWireFormat( PacketData &message, Offset offset ) const
     {
-        dns::outputWireFormat( labels, message, offset );
+        message.insert( message.end(), getData(), getData() + getDataLength() );
+        if ( offset == NO_COMPRESSION ) {
+            message.push_back( 0 );
+        } else {
+            message.push_back( 0xC0 | ( uint8_t )( offset >> 8 ) );
+            message.push_back( 0xff & (uint8_t)offset );
+        }
     }
 
     void Domainname::outputWireFormat( WireFormat &message, Offset offset ) const
     {
-        dns::outputWireFormat( labels, message, offset );
+        message.pushBuffer( getData(), getData() + getDataLength() );
+        if ( offset == NO_COMPRESSION ) {
+            message.push_back( 0 );
+        } else {
+            message.push_back( 0xC0 | ( uint8_t )( offset >> 8 ) );
+            message.push_back( 0xff & (uint8_t)offset );
+        }
     }
 
     PacketData Domainname::getCanonicalWireFormat() const
     {
         PacketData bin;
-        dns::outputWireFormat( canonical_labels, bin, NO_COMPRESSION );
+        outputCanonicalWireFormat( bin );
         return bin;
     }
 
     void Domainname::outputCanonicalWireFormat( PacketData &message ) const
     {
-        dns::outputWireFormat( canonical_labels, message, NO_COMPRESSION );
+        uint8_t buffer[ MAX_LENGTH ];
+        outputLowerCase( buffer );
+        buffer[ getDataLength() ] = 0;
+        message.insert( message.end(), buffer, buffer + getDataLength() + 1 );
     }
 
     void Domainname::outputCanonicalWireFormat( WireFormat &message ) const
     {
-        dns::outputWireFormat( canonical_labels, message, NO_COMPRESSION );
+        uint8_t buffer[ MAX_LENGTH ];
+        outputLowerCase( buffer );
+        buffer[ getDataLength() ] = 0;
+        message.pushBuffer( buffer, buffer + getDataLength() + 1 );
     }
 
     
@@ -207,22 +282,22 @@ namespace dns
                                             const uint8_t *begin,
                                             int            recur )
     {
-        if ( recur > 100 ) {
-            throw FormatError( "detected domainname decompress loop" );
-        }
         if ( packet_begin == packet_end ) {
             throw FormatError( "cannot parse empty data as a domainname" );
         }
 
-	std::ostringstream log;
-	log << std::hex << std::setw( 2 ) << std::setfill( '0' );
-	for ( const uint8_t *p = packet_begin ; p < packet_end ; p++ )
-	    log << "0x" << (uint32_t) *p << " ";
-	BOOST_LOG_TRIVIAL(trace) << "dns.domainname.parse: parse domainname " << log.str();
+        uint8_t        name[ MAX_LENGTH ];
+        unsigned int   name_length = 0;
+        const uint8_t *p           = begin;
+        const uint8_t *next        = nullptr;
+        while ( true ) {
+            if ( packet_end - p < 1 )
+                throw FormatError( "domainname size is too short(truncated ?)" );
+            if ( *p == 0 ) {
+                p++;
+                break;
+            }
 
-        std::string    label;
-        const uint8_t *p = begin;
-        while ( *p != 0 ) {
             // compressed
             if ( *p & 0xC0 ) {
                 if ( packet_end - p < 2 ) {
@@ -232,41 +307,67 @@ namespace dns
                 if ( packet_begin + offset > p - 2 ) {
                     throw FormatError( "detected forword reference of domainname decompress..." );
                 }
-
-                parsePacket( ref_domainname, packet_begin, packet_end, packet_begin + offset, recur + 1 );
-                return p + 2;
+                if ( ++recur > 100 ) {
+                    throw FormatError( "detected domainname decompress loop" );
+                }
+                if ( next == nullptr )
+                    next = p + 2;
+                p = packet_begin + offset;
+                continue;
             }
 
-            if ( packet_end - p < 1 )
-                throw FormatError( "domainname size is too short(truncated ?)" );
             uint8_t label_length = *p;
-            p++;
-
-            if ( packet_end - p < label_length )
+            if ( packet_end - p - 1 < label_length )
                 throw FormatError( "domainname size is too short(truncated ?)" );
-            for ( uint8_t i = 0; i < label_length; i++, p++ ) {
-                label.push_back( *p );
-            }
-            ref_domainname.addSuffix( label );
-            label = "";
+            if ( name_length + label_length + 1 > DATA_SIZE )
+                throwTooLongDomainname();
+            std::memcpy( name + name_length, p, label_length + 1 );
+            name_length += label_length + 1;
+            p           += label_length + 1;
         }
 
-        if ( packet_end - p < 1 )
-            throw FormatError( "domainname size is too short(truncated ?)" );
-        p++;
-        return p;
+        ref_domainname.appendWireFormat( name, name + name_length );
+        return next != nullptr ? next : p;
     }
 
     unsigned int Domainname::size( Offset offset ) const
     {
-	unsigned int size = 0;
-	for ( auto &label : labels ) {
-	    size += ( 1 + label.size() );
-	}
 	if ( offset == NO_COMPRESSION )
-	    return size + 1;
+	    return getDataLength() + 1;
 	else
-	    return size + 2;
+	    return getDataLength() + 2;
+    }
+
+    std::deque<std::string> Domainname::getLabels() const
+    {
+        std::deque<std::string> labels;
+        for ( unsigned int i = 0 ; i < getLabelCount() ; i++ )
+            labels.push_back( getLabel( i ) );
+        return labels;
+    }
+
+    std::deque<std::string> Domainname::getCanonicalLabels() const
+    {
+        std::deque<std::string> labels;
+        for ( unsigned int i = 0 ; i < getLabelCount() ; i++ )
+            labels.push_back( getCanonicalLabel( i ) );
+        return labels;
+    }
+
+    std::string Domainname::getLabel( unsigned int index ) const
+    {
+        if ( index >= getLabelCount() )
+            throw std::out_of_range( "label index is out of range" );
+        const uint8_t *label = getLabelBegin( index );
+        return std::string( reinterpret_cast<const char *>( label + 1 ), *label );
+    }
+
+    std::string Domainname::getCanonicalLabel( unsigned int index ) const
+    {
+        std::string label = getLabel( index );
+        for ( unsigned int i = 0 ; i < label.size() ; i++ )
+            label[i] = toLower( label[i] );
+        return label;
     }
 
     Domainname Domainname::operator+( const Domainname &rhs ) const
@@ -278,57 +379,78 @@ namespace dns
 
     Domainname &Domainname::operator+=( const Domainname &rhs )
     {
-        labels.insert( labels.end(), rhs.getLabels().begin(), rhs.getLabels().end() );
-        canonical_labels.insert( canonical_labels.end(),
-                                 rhs.getCanonicalLabels().begin(),
-                                 rhs.getCanonicalLabels().end() ); 
+        appendWireFormat( rhs.getData(), rhs.getData() + rhs.getDataLength() );
         return *this;
     }
 
     Domainname Domainname::getCanonicalDomainname() const
     {
-        return Domainname( getCanonicalLabels() );
+        Domainname canonical = *this;
+        canonical.outputLowerCase( canonical.mData + canonical.mBegin );
+        return canonical;
+    }
+
+    static void labelToWireFormat( const std::string &label, uint8_t *buffer )
+    {
+        if ( label.size() > Domainname::MAX_LABEL_LENGTH )
+            throw FormatError( "too long label" );
+        buffer[ 0 ] = label.size();
+        std::memcpy( buffer + 1, label.data(), label.size() );
     }
 
     void Domainname::addSubdomain( const std::string &label )
     {
-        labels.push_front( label );
-        canonical_labels.push_front( toLowerLabel( label ) );
+        if ( label.size() == 0 )
+            return;
+        uint8_t buffer[ MAX_LABEL_LENGTH + 1 ];
+        labelToWireFormat( label, buffer );
+        prependWireFormat( buffer, buffer + label.size() + 1 );
     }
 
     void Domainname::addSuffix( const std::string &label )
     {
-        labels.push_back( label );
-        canonical_labels.push_back( toLowerLabel( label ) );
+        if ( label.size() == 0 )
+            return;
+        uint8_t buffer[ MAX_LABEL_LENGTH + 1 ];
+        labelToWireFormat( label, buffer );
+        appendWireFormat( buffer, buffer + label.size() + 1 );
     }
 
 
     void Domainname::popSubdomain()
     {
-        labels.pop_front();
-        canonical_labels.pop_front();
+        if ( getLabelCount() == 0 )
+            return;
+        mBegin += mData[ mBegin ] + 1;
+        mFirstLabel++;
     }
 
     void Domainname::popSuffix()
     {
-        labels.pop_back();
-        canonical_labels.pop_back();
+        if ( getLabelCount() == 0 )
+            return;
+        unsigned int last   = MAX_LABEL_COUNT - 1;
+        unsigned int length = DATA_SIZE - mLabelOffsets[ last ];
+        std::memmove( mData + mBegin + length, mData + mBegin, DATA_SIZE - mBegin - length );
+        std::memmove( mLabelOffsets + mFirstLabel + 1, mLabelOffsets + mFirstLabel, last - mFirstLabel );
+        mBegin += length;
+        mFirstLabel++;
+        for ( unsigned int i = mFirstLabel ; i < MAX_LABEL_COUNT ; i++ )
+            mLabelOffsets[ i ] += length;
     }
 
     bool Domainname::isSubDomain( const Domainname &child ) const
     {
-	auto parent_labels = getCanonicalLabels();
-	auto child_labels  = child.getCanonicalLabels();
-	if ( child_labels.size() < labels.size() )
+	if ( child.getLabelCount() < getLabelCount() )
 	    return false;
+        if ( getLabelCount() == 0 )
+            return true;
 
-	auto parent_label = parent_labels.rbegin();
-	auto child_label  = child_labels.rbegin();
-	for ( ; parent_label != parent_labels.rend() ; parent_label++, child_label++ ) {
-	    if ( *parent_label != *child_label )
-		return false;
-	}
-	return true;
+        // the suffix of child must start at the label boundary.
+        const uint8_t *suffix = child.getLabelBegin( child.getLabelCount() - getLabelCount() );
+        if ( child.getData() + child.getDataLength() - suffix != getDataLength() )
+            return false;
+        return equalIgnoreCase( suffix, getData(), getDataLength() );
     }
 
     Domainname Domainname::getRelativeDomainname( const Domainname &child ) const
@@ -337,9 +459,10 @@ namespace dns
             throw DomainnameError( child.toString() + "is not sub-domaine of " + toString() + "." );
 
         Domainname relative;
-        unsigned int label_count = child.getLabels().size() - getLabels().size();
-        for ( unsigned int i = 0 ; i < label_count ; i++ ) {
-            relative.addSuffix( child.getLabels().at( i ) );
+        unsigned int label_count = child.getLabelCount() - getLabelCount();
+        if ( label_count > 0 ) {
+            const uint8_t *last_label = child.getLabelBegin( label_count - 1 );
+            relative.appendWireFormat( child.getData(), last_label + *last_label + 1 );
         }
 
         return relative;
@@ -357,14 +480,10 @@ namespace dns
 
     bool Domainname::operator==( const Domainname &rhs ) const
     {
-        if ( getCanonicalLabels().size() != rhs.getCanonicalLabels().size() )
+        // label length bytes are compared as they are, so the label boundaries are also equal.
+        if ( getDataLength() != rhs.getDataLength() )
             return false;
-
-        for ( unsigned int i = 0; i < getCanonicalLabels().size(); i++ ) {
-	    if ( getCanonicalLabels().at( i ) != rhs.getCanonicalLabels().at( i ) )
-		return false;
-        }
-        return true;
+        return equalIgnoreCase( getData(), rhs.getData(), getDataLength() );
     }
 
     bool Domainname::operator!=( const Domainname &rhs ) const
@@ -374,20 +493,18 @@ namespace dns
 
     bool Domainname::operator<( const Domainname &rhs ) const
     {
-	if ( *this == rhs )
-	    return false;
+	int lhs_index = getLabelCount() - 1;
+	int rhs_index = rhs.getLabelCount() - 1;
 
-	auto llabel = getCanonicalLabels().rbegin();
-	auto rlabel = rhs.getCanonicalLabels().rbegin();
-
-	for ( ; true ; llabel++, rlabel++ ) {
-	    if ( llabel == getCanonicalLabels().rend() )
-		return true;
-	    if ( rlabel == rhs.getCanonicalLabels().rend() )
+	for ( ; true ; lhs_index--, rhs_index-- ) {
+	    if ( lhs_index < 0 )
+		return rhs_index >= 0;
+	    if ( rhs_index < 0 )
 		return false;
-	    if ( *llabel == *rlabel )
+            int result = compareLabel( getLabelBegin( lhs_index ), rhs.getLabelBegin( rhs_index ) );
+	    if ( result == 0 )
 		continue;
-	    return *llabel < *rlabel;
+	    return result < 0;
 	}
     }
 
@@ -407,69 +524,174 @@ namespace dns
         return (Domainname)lhs > rhs;
     }
 
-    uint16_t OffsetDB::findDomainname( const Domainname &name ) const
+    OffsetDB::OffsetDB()
+        : mEntryCount( 0 ), mPoolSize( 0 ), mRecordedNames( nullptr )
     {
-        OffsetContainerIterator offset = mOffsets.find( name );
-        if ( offset == mOffsets.end() )
-            return NOT_FOUND;
-        else
-            return offset->second;
+        for ( unsigned int i = 0 ; i < TABLE_SIZE ; i++ )
+            mTable[ i ] = NO_ENTRY;
     }
 
-    void OffsetDB::add( const Domainname &name, uint32_t offset )
+    OffsetDB::OffsetDB( NameOffsets &names )
+        : mEntryCount( 0 ), mPoolSize( 0 ), mRecordedNames( &names )
     {
-        if ( NOT_FOUND == findDomainname( name ) ) 
-            mOffsets.insert( std::make_pair( name, offset ) );
+        for ( unsigned int i = 0 ; i < TABLE_SIZE ; i++ )
+            mTable[ i ] = NO_ENTRY;
     }
 
-    uint32_t OffsetDB::outputWireFormat( const Domainname &original, WireFormat &message )
+    void OffsetDB::splitSuffixes( const Domainname &name, Suffixes &suffixes )
     {
-        uint32_t pos = message.size();
-        uint32_t wrote_size = 0;
-        
-        for ( Domainname name = original ; name.getLabelCount() > 0 ; ) {
-            uint16_t offset = findDomainname( name );
-            if ( offset != NOT_FOUND ) {
-                message.pushUInt8( 0xC0 | ( ( offset >> 8 ) & 0xff ) );
-                message.pushUInt8( 0xff & offset );
-                wrote_size += 2;
-                return wrote_size;
-            }
-            else {
-                add( name, pos );
-                std::string label = name.getLabels().front();
-                message.pushUInt8( label.size() );
-                message.pushBuffer( label );
-                pos += ( 1 + label.size() );
-                wrote_size += ( 1 + label.size() );
-                name.popSubdomain();
+        const uint8_t *data = name.getData();
+        suffixes.mCount     = name.getLabelCount();
+        for ( unsigned int i = 0, pos = 0 ; i < suffixes.mCount ; i++ ) {
+            suffixes.mLabels[ i ] = data + pos;
+            pos += data[ pos ] + 1;
+        }
+
+        // FNV-1a hash of lowercase labels from root, so that the hash of a suffix does not depend on its subdomains.
+        uint32_t hash = 2166136261u;
+        for ( int i = suffixes.mCount - 1 ; i >= 0 ; i-- ) {
+            const uint8_t *label = suffixes.mLabels[ i ];
+            for ( unsigned int j = 0 ; j <= *label ; j++ ) {
+                hash ^= toLower( label[ j ] );
+                hash *= 16777619u;
             }
+            suffixes.mHashes[ i ] = hash;
         }
-        message.pushUInt8( 0 );
-        wrote_size++;
+    }
 
+    bool OffsetDB::isSameSuffix( const Suffixes &suffixes, unsigned int index, uint16_t entry ) const
+    {
+        for ( unsigned int i = index ; i < suffixes.mCount ; i++ ) {
+            if ( entry == NO_ENTRY )
+                return false;
+            const uint8_t *label = suffixes.mLabels[ i ];
+            if ( ! equalIgnoreCase( label, mPool + mEntries[ entry ].mLabel, *label + 1 ) )
+                return false;
+            entry = mEntries[ entry ].mNext;
+        }
+        return entry == NO_ENTRY;
+    }
+
+    uint16_t OffsetDB::findSuffix( const Suffixes &suffixes, unsigned int index ) const
+    {
+        uint32_t hash = suffixes.mHashes[ index ];
+        for ( uint32_t slot = hash & ( TABLE_SIZE - 1 ) ; mTable[ slot ] != NO_ENTRY ; slot = ( slot + 1 ) & ( TABLE_SIZE - 1 ) ) {
+            uint16_t entry = mTable[ slot ];
+            if ( mEntries[ entry ].mHash == hash && isSameSuffix( suffixes, index, entry ) )
+                return entry;
+        }
+        return NO_ENTRY;
+    }
+
+    uint16_t OffsetDB::addSuffix( const Suffixes &suffixes, unsigned int index, uint32_t offset, uint16_t next )
+    {
+        const uint8_t *label = suffixes.mLabels[ index ];
+        if ( mEntryCount >= MAX_ENTRY_COUNT || static_cast<unsigned int>( mPoolSize ) + *label + 1 > POOL_SIZE || offset > MAX_OFFSET )
+            return NO_ENTRY;
+
+        std::memcpy( mPool + mPoolSize, label, *label + 1 );
+        Entry &entry  = mEntries[ mEntryCount ];
+        entry.mHash   = suffixes.mHashes[ index ];
+        entry.mOffset = offset;
+        entry.mLabel  = mPoolSize;
+        entry.mNext   = next;
+        mPoolSize += *label + 1;
+
+        uint32_t slot = entry.mHash & ( TABLE_SIZE - 1 );
+        while ( mTable[ slot ] != NO_ENTRY )
+            slot = ( slot + 1 ) & ( TABLE_SIZE - 1 );
+        mTable[ slot ] = mEntryCount;
+        return mEntryCount++;
+    }
+
+    /*!
+     * find the longest suffix which was already written, and register suffixes which will be written at begin.
+     * @return count of labels which will be written uncompressed. found is set to the entry of the compressed suffix.
+     */
+    unsigned int OffsetDB::registerSuffixes( const Suffixes &suffixes, uint32_t begin, uint16_t &found )
+    {
+        unsigned int uncompressed = 0;
+        found = NO_ENTRY;
+        for ( ; uncompressed < suffixes.mCount ; uncompressed++ ) {
+            found = findSuffix( suffixes, uncompressed );
+            if ( found != NO_ENTRY )
+                break;
+        }
+
+        // a suffix refers the next suffix, so register from the shortest one.
+        uint16_t next = found;
+        for ( int i = (int)uncompressed - 1 ; i >= 0 ; i-- ) {
+            uint32_t offset = begin + ( suffixes.mLabels[ i ] - suffixes.mLabels[ 0 ] );
+            next = addSuffix( suffixes, i, offset, next );
+            if ( next == NO_ENTRY )
+                break; // longer suffixes cannot refer this suffix.
+        }
+        return uncompressed;
+    }
+
+    uint32_t OffsetDB::outputWireFormat( const Domainname &name, WireFormat &message )
+    {
+        if ( mRecordedNames ) {
+            mRecordedNames->push_back( std::make_pair( message.size(), name ) );
+            name.outputWireFormat( message );
+            return name.size();
+        }
+
+        Suffixes suffixes;
+        splitSuffixes( name, suffixes );
+
+        uint16_t       found;
+        unsigned int   uncompressed = registerSuffixes( suffixes, message.size(), found );
+        const uint8_t *end          = uncompressed < suffixes.mCount ? suffixes.mLabels[ uncompressed ] : name.getData() + name.getDataLength();
+        message.pushBuffer( name.getData(), end );
+
+        uint32_t wrote_size = end - name.getData();
+        if ( found != NO_ENTRY ) {
+            uint16_t offset = mEntries[ found ].mOffset;
+            message.pushUInt8( 0xC0 | ( ( offset >> 8 ) & 0xff ) );
+            message.pushUInt8( 0xff & offset );
+            wrote_size += 2;
+        }
+        else {
+            message.pushUInt8( 0 );
+            wrote_size++;
+        }
         return wrote_size;
     }
 
-    uint32_t OffsetDB::getOutputWireFormatSize( const Domainname &original, uint32_t begin )
+    uint32_t OffsetDB::getOutputWireFormatSize( const Domainname &name, uint32_t begin )
     {
-        uint16_t pos = begin;
+        if ( mRecordedNames )
+            return name.size();
 
-        for ( Domainname name = original ; name.getLabelCount() > 0 ; ) {
-            uint16_t offset = findDomainname( name );
-            if ( offset != NOT_FOUND ) {
-                pos += 2;
-                return pos - begin;
-            }
-            else {
-                add( name, pos );
-                std::string label = name.getLabels().front();
-                pos++;               // write label size
-                pos += label.size(); // write label
-                name.popSubdomain();
-            }
+        Suffixes suffixes;
+        splitSuffixes( name, suffixes );
+
+        uint16_t       found;
+        unsigned int   uncompressed = registerSuffixes( suffixes, begin, found );
+        const uint8_t *end          = uncompressed < suffixes.mCount ? suffixes.mLabels[ uncompressed ] : name.getData() + name.getDataLength();
+
+        return ( end - name.getData() ) + ( found != NO_ENTRY ? 2 : 1 );
+    }
+
+    OffsetDB::State OffsetDB::getState() const
+    {
+        State state;
+        state.mEntryCount = mEntryCount;
+        state.mPoolSize   = mPoolSize;
+        return state;
+    }
+
+    void OffsetDB::restoreState( const State &state )
+    {
+        // remove entries in reverse order of insertion, so that probe sequences of remaining entries are kept.
+        while ( mEntryCount > state.mEntryCount ) {
+            mEntryCount--;
+            uint32_t slot = mEntries[ mEntryCount ].mHash & ( TABLE_SIZE - 1 );
+            while ( mTable[ slot ] != mEntryCount )
+                slot = ( slot + 1 ) & ( TABLE_SIZE - 1 );
+            mTable[ slot ] = NO_ENTRY;
         }
-        pos++; // write "."
-        return pos - begin;
+        mPoolSize = state.mPoolSize;
     }
 }
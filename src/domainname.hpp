@@ -3,9 +3,9 @@
 
 #include "wireformat.hpp"
 #include <deque>
-#include <map>
 #include <iostream>
 #include <stdexcept>
+#include <vector>
 #include <boost/operators.hpp>
 
 namespace dns
@@ -40,16 +40,41 @@ namespace dns
 
 
 
+    /*!
+     * domainname stored as uncompressed wire format without root label, and offsets of labels.
+     * Both are stored in the object and right-aligned, so that popSubdomain and addSubdomain
+     * only move the head. Comparison ignores case without making lowercase copies.
+     */
     class Domainname : public boost::less_than_comparable<Domainname>
     {
+    public:
+        static const unsigned int MAX_LENGTH       = 255; // wire format size including root label
+        static const unsigned int MAX_LABEL_LENGTH = 63;
+        static const unsigned int MAX_LABEL_COUNT  = 127;
+
     private:
-        std::deque<std::string> labels;
-        std::deque<std::string> canonical_labels;
+        static const unsigned int DATA_SIZE = MAX_LENGTH - 1;
+
+        uint8_t mData[ DATA_SIZE ];            // labels are stored in [ mBegin, DATA_SIZE )
+        uint8_t mLabelOffsets[ MAX_LABEL_COUNT ]; // offsets of labels are stored in [ mFirstLabel, MAX_LABEL_COUNT )
+        uint8_t mBegin;
+        uint8_t mFirstLabel;
+
+        const uint8_t *getLabelBegin( unsigned int index ) const
+        {
+            return mData + mLabelOffsets[ mFirstLabel + index ];
+        }
+
+        void prependWireFormat( const uint8_t *begin, const uint8_t *end );
+        void appendWireFormat( const uint8_t *begin, const uint8_t *end );
+        void outputLowerCase( uint8_t *buffer ) const;
 
     public:
         Domainname( const std::deque<std::string> &l = std::deque<std::string>() );
         explicit Domainname( const std::string &name );
         Domainname( const char *name );
+        Domainname( const Domainname & );
+        Domainname &operator=( const Domainname & );
 
         std::string toString() const;
 
@@ -68,17 +93,34 @@ namespace dns
 
         unsigned int size( Offset offset = NO_COMPRESSION ) const;
 
-        const std::deque<std::string> &getLabels() const
+        /*!
+         * @return uncompressed wire format without root label.
+         */
+        const uint8_t *getData() const
+        {
+            return mData + mBegin;
+        }
+        unsigned int getDataLength() const
         {
-            return labels;
+            return DATA_SIZE - mBegin;
         }
-        const std::deque<std::string> &getCanonicalLabels() const
+
+        std::deque<std::string> getLabels() const;
+        std::deque<std::string> getCanonicalLabels() const;
+        std::string getLabel( unsigned int index ) const;
+        std::string getCanonicalLabel( unsigned int index ) const;
+
+        /*!
+         * @return the label of the index in wire format( length and bytes ), which is valid while the name is not modified.
+         */
+        const uint8_t *getLabelData( unsigned int index ) const
         {
-            return canonical_labels;
+            return getLabelBegin( index );
         }
+
         const uint32_t getLabelCount() const
         {
-            return labels.size();
+            return MAX_LABEL_COUNT - mFirstLabel;
         }
 
         Domainname  operator+( const Domainname & ) const;
@@ -115,23 +157,75 @@ namespace dns
     bool operator!=( const std::string &lhs, const Domainname &rhs );
     bool operator<( const std::string &lhs, const Domainname &rhs );
 
+    /*!
+     * compression table of domainnames which were written to a message.
+     * Each entry is a suffix of a written domainname, and it is found by the hash of the suffix
+     * in the fixed size open addressing table. Labels of the written suffixes are kept in the inline pool
+     * to verify candidates, so the same table works for both outputWireFormat and getOutputWireFormatSize.
+     * No heap memory is allocated. When the table is full, following names are written without compression.
+     */
     class OffsetDB
     {
-    private:
-        typedef std::map<Domainname,uint16_t>   OffsetContainer;
-        typedef OffsetContainer::const_iterator OffsetContainerIterator;
+    public:
+        static const uint32_t NOT_FOUND = 0xffff;
 
-        OffsetContainer mOffsets;
+        /*!
+         * registered entries, which are used to roll back entries added after getState().
+         */
+        struct State {
+            uint16_t mEntryCount;
+            uint16_t mPoolSize;
+        };
 
-        uint16_t findDomainname( const Domainname &name ) const;
-        void add( const Domainname &name, uint32_t offset );
-    public:
-        const uint32_t NOT_FOUND = 0xffff;
+        typedef std::vector<std::pair<uint16_t, Domainname> > NameOffsets;
+
+        OffsetDB();
+
+        /*!
+         * OffsetDB which does not compress names, but records written names and their offsets to names.
+         * It is used to precompile RDATA.
+         */
+        explicit OffsetDB( NameOffsets &names );
 
         uint32_t outputWireFormat( const Domainname &, WireFormat & );
         uint32_t getOutputWireFormatSize( const Domainname &, uint32_t begin );
-    };
 
+        State getState() const;
+        void  restoreState( const State &state );
+
+    private:
+        static const unsigned int MAX_ENTRY_COUNT = 256;
+        static const unsigned int TABLE_SIZE      = 512; // power of 2, twice of MAX_ENTRY_COUNT
+        static const unsigned int POOL_SIZE       = 4096;
+        static const uint16_t     NO_ENTRY        = 0xffff;
+        static const uint32_t     MAX_OFFSET      = 0x3fff; // max offset of compression pointer
+
+        struct Entry {
+            uint32_t mHash;
+            uint16_t mOffset; // offset of the suffix in message
+            uint16_t mLabel;  // position of the first label of the suffix in mPool
+            uint16_t mNext;   // entry of the suffix without the first label, or NO_ENTRY for root
+        };
+
+        uint16_t     mTable[ TABLE_SIZE ]; // index of mEntries, or NO_ENTRY
+        Entry        mEntries[ MAX_ENTRY_COUNT ];
+        uint8_t      mPool[ POOL_SIZE ];
+        uint16_t     mEntryCount;
+        uint16_t     mPoolSize;
+        NameOffsets *mRecordedNames; // not NULL in recording mode
+
+        struct Suffixes {
+            const uint8_t *mLabels[ Domainname::MAX_LABEL_COUNT ];
+            uint32_t       mHashes[ Domainname::MAX_LABEL_COUNT ];
+            unsigned int   mCount;
+        };
+
+        static void  splitSuffixes( const Domainname &name, Suffixes &suffixes );
+        uint16_t     findSuffix( const Suffixes &suffixes, unsigned int index ) const;
+        bool         isSameSuffix( const Suffixes &suffixes, unsigned int index, uint16_t entry ) const;
+        uint16_t     addSuffix( const Suffixes &suffixes, unsigned int index, uint32_t offset, uint16_t next );
+        unsigned int registerSuffixes( const Suffixes &suffixes, uint32_t begin, uint16_t &found );
+    };
 
 }
 
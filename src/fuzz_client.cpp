@@ -301,7 +301,7 @@ void generate_query( const dns::Domainname &basename,
         unsigned int shuffle_count = dns::getRandom( 3 );
         for ( unsigned int i = 0 ; i < shuffle_count ; i++ ) {
             if ( dns::getRandom( 8 ) == 0 ) {
-                WireFormat src = ref_query;
+                WireFormat src( std::move( ref_query ) );
                 dns::shuffle( src, ref_query );
             }
         }
@@ -192,7 +192,7 @@ namespace dns
 	{
             unsigned int shuffle_count = getRandom( 1 );
             for ( unsigned int i = 0 ; i < shuffle_count ; i++ ) {
-                WireFormat src = message;
+                WireFormat src( std::move( message ) );
                 dns::shuffle( src, message );
             }
 	}
@@ -283,6 +283,8 @@ int main( int argc, char **argv )
     uint16_t             nsec3_iterate;
     uint16_t             nsec3_hash_algo;
     std::string          another_hint;
+    unsigned int         udp_queue_size;
+    std::string          overload_policy;
     
     po::options_description desc( "fuzz server" );
     desc.add_options()( "help,h", "print this message" )
@@ -291,6 +293,11 @@ int main( int argc, char **argv )
         ( "port,p",       po::value<uint16_t>( &bind_port )->default_value( 53 ),              "bind port" )
         ( "thread,n",     po::value<uint16_t>( &thread_count )->default_value( 1 ),            "thread count" )
 	( "multicast,m",                                                                       "multicast" )  
+        ( "reuseport",                                                                         "open SO_REUSEPORT UDP socket per thread" )
+        ( "work-stealing",                                                                     "use work-stealing thread pool" )
+        ( "cpu-affinity",                                                                      "bind worker threads to CPUs" )
+        ( "udp-queue",    po::value<unsigned int>( &udp_queue_size )->default_value( 64 ),     "count of queued UDP batches" )
+        ( "overload",     po::value<std::string>( &overload_policy )->default_value( "drop-newest" ), "drop-newest, drop-oldest, refused or truncate" )
 	( "file,f",       po::value<std::string>( &zone_filename ),                            "zone filename" )
 	( "zone,z",       po::value<std::string>( &apex),                                      "zone apex" )
 	( "another,a",    po::value<std::string>( &another_hint ),                             "another domainname for cache poisoning" )
@@ -328,6 +335,12 @@ int main( int argc, char **argv )
 	params.mBindPort    = bind_port;
 	params.mMulticast   = vm.count( "multicast" ) > 0;
 	params.mThreadCount = thread_count;
+	params.mUDPReusePort = vm.count( "reuseport" ) > 0;
+	params.mWorkStealing = vm.count( "work-stealing" ) > 0;
+	params.mCPUAffinity  = vm.count( "cpu-affinity" ) > 0;
+	params.mUDPQueueSize = udp_queue_size;
+	params.mUDPOverloadPolicy = dns::stringToOverloadPolicy( overload_policy );
+	params.mModifyResponses   = true;
 	dns::FuzzServer server( params, (dns::Domainname)another_hint );
 	server.load( apex, zone_filename,
                      ksk_filename, zsk_filename,
@@ -0,0 +1,161 @@
+#include "messageview.hpp"
+#include <arpa/inet.h>
+
+namespace dns
+{
+    static uint16_t readUInt16( const uint8_t *pos )
+    {
+        return ( pos[ 0 ] << 8 ) + pos[ 1 ];
+    }
+
+    MessageView::MessageView( const uint8_t *begin, const uint8_t *end )
+        : mBegin( begin ), mEnd( end ), mQuestion( nullptr ), mQuestionType( nullptr ), mOpt( nullptr ), mTSIG( nullptr )
+    {
+        if ( end - begin < (ptrdiff_t)sizeof( PacketHeaderField ) )
+            throw FormatError( "too short message size( less than DNS message header size )." );
+
+        const uint8_t *pos = begin + sizeof( PacketHeaderField );
+        for ( uint16_t i = 0 ; i < getQuestionCount() ; i++ ) {
+            const uint8_t *qname = pos;
+            pos = skipDomainname( pos );
+            if ( mEnd - pos < 4 )
+                throw FormatError( "too short question." );
+            if ( i == 0 ) {
+                mQuestion     = qname;
+                mQuestionType = pos;
+            }
+            pos += 4;
+        }
+
+        unsigned int rr_count = getAnswerCount() + getAuthorityCount();
+        for ( unsigned int i = 0 ; i < rr_count ; i++ )
+            pos = skipResourceRecord( pos, nullptr );
+
+        for ( uint16_t i = 0 ; i < getAdditionalCount() ; i++ ) {
+            const uint8_t *type_pos;
+            pos = skipResourceRecord( pos, &type_pos );
+            Type type = readUInt16( type_pos );
+            if ( type == TYPE_OPT ) {
+                if ( mOpt != nullptr )
+                    throw FormatError( "multiple OPT pseudo records." );
+                mOpt = type_pos;
+            }
+            if ( type == TYPE_TSIG && readUInt16( type_pos + 2 ) == CLASS_IN )
+                mTSIG = type_pos;
+        }
+    }
+
+    const uint8_t *MessageView::skipDomainname( const uint8_t *pos ) const
+    {
+        unsigned int length = 0;
+        while ( true ) {
+            if ( pos >= mEnd )
+                throw FormatError( "domainname is out of message." );
+            uint8_t label_length = *pos;
+            if ( ( label_length & 0xc0 ) == 0xc0 ) {
+                if ( mEnd - pos < 2 )
+                    throw FormatError( "compression pointer is out of message." );
+                if ( ( ( label_length & 0x3f ) << 8 ) + pos[ 1 ] >= mEnd - mBegin )
+                    throw FormatError( "compression pointer refers out of message." );
+                return pos + 2;
+            }
+            if ( label_length & 0xc0 )
+                throw FormatError( "unknown label type." );
+            length += label_length + 1;
+            if ( length > 255 )
+                throw FormatError( "too long domainname." );
+            pos += label_length + 1;
+            if ( label_length == 0 )
+                return pos;
+        }
+    }
+
+    const uint8_t *MessageView::skipResourceRecord( const uint8_t *pos, const uint8_t **type_pos ) const
+    {
+        pos = skipDomainname( pos );
+        if ( mEnd - pos < 10 )
+            throw FormatError( "too short resource record." );
+        if ( type_pos )
+            *type_pos = pos;
+        uint16_t rdata_length = readUInt16( pos + 8 );
+        pos += 10;
+        if ( mEnd - pos < rdata_length )
+            throw FormatError( "RDATA is out of message." );
+        return pos + rdata_length;
+    }
+
+    uint16_t MessageView::getID() const
+    {
+        return ntohs( getHeader().id );
+    }
+
+    uint16_t MessageView::getQuestionCount() const
+    {
+        return ntohs( getHeader().question_count );
+    }
+
+    uint16_t MessageView::getAnswerCount() const
+    {
+        return ntohs( getHeader().answer_count );
+    }
+
+    uint16_t MessageView::getAuthorityCount() const
+    {
+        return ntohs( getHeader().authority_count );
+    }
+
+    uint16_t MessageView::getAdditionalCount() const
+    {
+        return ntohs( getHeader().additional_infomation_count );
+    }
+
+    Domainname MessageView::getQuestionDomainname() const
+    {
+        if ( ! hasQuestion() )
+            throw std::logic_error( "no question in message." );
+        Domainname qname;
+        Domainname::parsePacket( qname, mBegin, mEnd, mQuestion );
+        return qname;
+    }
+
+    Type MessageView::getQuestionType() const
+    {
+        if ( ! hasQuestion() )
+            throw std::logic_error( "no question in message." );
+        return readUInt16( mQuestionType );
+    }
+
+    Class MessageView::getQuestionClass() const
+    {
+        if ( ! hasQuestion() )
+            throw std::logic_error( "no question in message." );
+        return readUInt16( mQuestionType + 2 );
+    }
+
+    // OPT: TYPE(2) CLASS=payload size(2) TTL=extended rcode(1),version(1),DO+Z(2)
+    uint16_t MessageView::getPayloadSize() const
+    {
+        if ( ! isEDNS0() )
+            throw std::logic_error( "no OPT pseudo record in message." );
+        return readUInt16( mOpt + 2 );
+    }
+
+    uint8_t MessageView::getEDNSVersion() const
+    {
+        if ( ! isEDNS0() )
+            throw std::logic_error( "no OPT pseudo record in message." );
+        return mOpt[ 5 ];
+    }
+
+    bool MessageView::getDOBit() const
+    {
+        if ( ! isEDNS0() )
+            throw std::logic_error( "no OPT pseudo record in message." );
+        return ( mOpt[ 6 ] & 0x80 ) != 0;
+    }
+
+    MessageInfo MessageView::getMessageInfo() const
+    {
+        return parseDNSMessage( mBegin, mEnd );
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef MESSAGEVIEW_HPP
+#define MESSAGEVIEW_HPP
+
+#include "dns.hpp"
+
+namespace dns
+{
+    /*!
+     * read only view of DNS message over the received buffer.
+     * The constructor validates structure of all sections in one pass without allocating memory,
+     * and remembers positions of the first question, OPT and TSIG pseudo records.
+     * The buffer must outlive the view.
+     */
+    class MessageView
+    {
+    public:
+        /*!
+         * @throw FormatError if the message is broken.
+         */
+        MessageView( const uint8_t *begin, const uint8_t *end );
+
+        const uint8_t *begin() const { return mBegin; }
+        const uint8_t *end() const   { return mEnd; }
+
+        uint16_t getID() const;
+        uint8_t  getQueryResponse() const      { return getHeader().query_response; }
+        Opcode   getOpcode() const             { return getHeader().opcode; }
+        bool     getRecursionDesired() const   { return getHeader().recursion_desired; }
+        bool     getCheckingDisabled() const   { return getHeader().checking_disabled; }
+        uint8_t  getResponseCode() const       { return getHeader().response_code; }
+
+        uint16_t getQuestionCount() const;
+        uint16_t getAnswerCount() const;
+        uint16_t getAuthorityCount() const;
+        uint16_t getAdditionalCount() const;
+
+        bool hasQuestion() const { return mQuestion != nullptr; }
+
+        /*!
+         * @return QNAME of the first question. It is decoded at each call.
+         */
+        Domainname getQuestionDomainname() const;
+        Type       getQuestionType() const;
+        Class      getQuestionClass() const;
+
+        /*!
+         * @return position of QNAME of the first question in the message, or NULL.
+         */
+        const uint8_t *getQuestionPosition() const { return mQuestion; }
+
+        bool     isEDNS0() const { return mOpt != nullptr; }
+        uint16_t getPayloadSize() const;
+        uint8_t  getEDNSVersion() const;
+        bool     getDOBit() const;
+        bool     isDNSSECOK() const { return isEDNS0() && getDOBit(); }
+
+        bool isTSIG() const { return mTSIG != nullptr; }
+
+        /*!
+         * parse whole message for TSIG verification and servers which need all sections.
+         */
+        MessageInfo getMessageInfo() const;
+
+    private:
+        const uint8_t *mBegin;
+        const uint8_t *mEnd;
+        const uint8_t *mQuestion;      // QNAME of the first question
+        const uint8_t *mQuestionType;  // QTYPE of the first question
+        const uint8_t *mOpt;           // TYPE of OPT pseudo record
+        const uint8_t *mTSIG;          // TYPE of TSIG record
+
+        const PacketHeaderField &getHeader() const
+        {
+            return *reinterpret_cast<const PacketHeaderField *>( mBegin );
+        }
+
+        const uint8_t *skipDomainname( const uint8_t *pos ) const;
+        const uint8_t *skipResourceRecord( const uint8_t *pos, const uint8_t **type_pos ) const;
+    };
+}
+
+#endif
@@ -0,0 +1,128 @@
+#ifndef MPMCQUEUE_HPP
+#define MPMCQUEUE_HPP
+
+#include <boost/noncopyable.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace utils
+{
+    /*!
+     * bounded lock-free multi producer / multi consumer queue.
+     * each cell has a sequence number which tells producers and consumers whether the cell is ready.
+     * capacity is rounded up to power of 2.
+     */
+    template <typename T>
+    class MPMCQueue : private boost::noncopyable
+    {
+    public:
+        MPMCQueue( size_t capacity )
+            : mBufferMask( roundUpToPowerOf2( capacity ) - 1 ), mCells( mBufferMask + 1 ),
+              mEnqueuePosition( 0 ), mDequeuePosition( 0 )
+        {
+            for ( size_t i = 0; i < mCells.size(); i++ )
+                mCells[ i ].mSequence.store( i, std::memory_order_relaxed );
+        }
+
+        size_t capacity() const
+        {
+            return mBufferMask + 1;
+        }
+
+        /*!
+         * @return false if queue is full.
+         */
+        bool push( const T &data )
+        {
+            Cell * cell;
+            size_t position = mEnqueuePosition.load( std::memory_order_relaxed );
+            while ( true ) {
+                cell = &mCells[ position & mBufferMask ];
+                size_t   sequence = cell->mSequence.load( std::memory_order_acquire );
+                intptr_t diff     = (intptr_t)sequence - (intptr_t)position;
+                if ( diff == 0 ) {
+                    if ( mEnqueuePosition.compare_exchange_weak( position, position + 1, std::memory_order_relaxed ) )
+                        break;
+                }
+                else if ( diff < 0 ) {
+                    return false;
+                }
+                else {
+                    position = mEnqueuePosition.load( std::memory_order_relaxed );
+                }
+            }
+            cell->mData = data;
+            cell->mSequence.store( position + 1, std::memory_order_release );
+            return true;
+        }
+
+        /*!
+         * @return false if queue is empty.
+         */
+        bool pop( T &data )
+        {
+            Cell * cell;
+            size_t position = mDequeuePosition.load( std::memory_order_relaxed );
+            while ( true ) {
+                cell = &mCells[ position & mBufferMask ];
+                size_t   sequence = cell->mSequence.load( std::memory_order_acquire );
+                intptr_t diff     = (intptr_t)sequence - (intptr_t)( position + 1 );
+                if ( diff == 0 ) {
+                    if ( mDequeuePosition.compare_exchange_weak( position, position + 1, std::memory_order_relaxed ) )
+                        break;
+                }
+                else if ( diff < 0 ) {
+                    return false;
+                }
+                else {
+                    position = mDequeuePosition.load( std::memory_order_relaxed );
+                }
+            }
+            data = cell->mData;
+            cell->mData = T();
+            cell->mSequence.store( position + mBufferMask + 1, std::memory_order_release );
+            return true;
+        }
+
+        /*!
+         * @return approximate count of elements.
+         */
+        size_t size() const
+        {
+            size_t enqueue_position = mEnqueuePosition.load( std::memory_order_relaxed );
+            size_t dequeue_position = mDequeuePosition.load( std::memory_order_relaxed );
+            return enqueue_position > dequeue_position ? enqueue_position - dequeue_position : 0;
+        }
+
+    private:
+        static const size_t CACHE_LINE_SIZE = 64;
+
+        struct Cell {
+            std::atomic<size_t> mSequence;
+            T                   mData;
+
+            Cell() : mSequence( 0 ) {}
+            Cell( const Cell & ) : mSequence( 0 ) {}
+        };
+
+        static size_t roundUpToPowerOf2( size_t capacity )
+        {
+            size_t size = 2;
+            while ( size < capacity )
+                size <<= 1;
+            return size;
+        }
+
+        const size_t        mBufferMask;
+        std::vector<Cell>   mCells;
+        char                mPadding1[ CACHE_LINE_SIZE ];
+        std::atomic<size_t> mEnqueuePosition;
+        char                mPadding2[ CACHE_LINE_SIZE ];
+        std::atomic<size_t> mDequeuePosition;
+        char                mPadding3[ CACHE_LINE_SIZE ];
+    };
+}
+
+#endif
@@ -52,8 +52,6 @@ int main( int argc, char **argv )
     packet_info.mOptPseudoRR.mDOBit       = 1;
     packet_info.mIsEDNS0                  = true;
 
-    std::shared_ptr<dns::RecordOptionsData> options = std::dynamic_pointer_cast<dns::RecordOptionsData>(packet_info.mOptPseudoRR.mOptions);
-
     std::vector<uint16_t> keytags1, keytags2;
     for ( uint16_t i = 0 ; i < 32000 ; i++ ) {
         keytags1.push_back( i );
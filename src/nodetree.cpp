@@ -0,0 +1,119 @@
+#include "nodetree.hpp"
+
+namespace dns
+{
+    static uint8_t toLower( uint8_t c )
+    {
+        return ( 'A' <= c && c <= 'Z' ) ? c + ( 'a' - 'A' ) : c;
+    }
+
+    bool NodeTree::ChildKey::operator==( const ChildKey &rhs ) const
+    {
+        if ( mParent != rhs.mParent || mLabel[ 0 ] != rhs.mLabel[ 0 ] )
+            return false;
+        for ( unsigned int i = 1 ; i <= mLabel[ 0 ] ; i++ ) {
+            if ( mLabel[ i ] != rhs.mLabel[ i ] && toLower( mLabel[ i ] ) != toLower( rhs.mLabel[ i ] ) )
+                return false;
+        }
+        return true;
+    }
+
+    size_t NodeTree::ChildKeyHash::operator()( const ChildKey &key ) const
+    {
+        // FNV-1a over the lowercase label and the parent.
+        size_t hash = 14695981039346656037ULL ^ reinterpret_cast<uintptr_t>( key.mParent );
+        for ( unsigned int i = 1 ; i <= key.mLabel[ 0 ] ; i++ ) {
+            hash ^= toLower( key.mLabel[ i ] );
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    NodeTree::NodeTree( const Domainname &apex, const utils::ArenaPtr &arena )
+        : mApex( apex ), mArena( arena )
+    {
+        if ( ! mArena )
+            mArena.reset( new utils::Arena );
+        mEntries.push_back( Entry( apex, newNode() ) );
+    }
+
+    NodeTree::NodePtr NodeTree::newNode() const
+    {
+        return std::allocate_shared<Node>( utils::ArenaAllocator<Node>( mArena ) );
+    }
+
+    NodeTree::Entry *NodeTree::findChild( const Entry *parent, const uint8_t *label ) const
+    {
+        ChildKey key;
+        key.mParent = parent;
+        key.mLabel  = label;
+        auto child = mChildren.find( key );
+        if ( child == mChildren.end() )
+            return nullptr;
+        return child->second;
+    }
+
+    NodeTree::NodePtr NodeTree::add( const Domainname &name )
+    {
+        if ( ! mApex.isSubDomain( name ) )
+            throw std::logic_error( name.toString() + " is not contained in " + mApex.toString() );
+
+        Entry *entry = &mEntries.front();
+        for ( int i = name.getLabelCount() - mApex.getLabelCount() - 1 ; i >= 0 ; i-- ) {
+            Entry *child = findChild( entry, name.getLabelData( i ) );
+            if ( child == nullptr ) {
+                std::string label      = name.getCanonicalLabel( i );
+                Domainname  child_name = entry->first;
+                child_name.addSubdomain( label );
+                mEntries.push_back( Entry( child_name, newNode() ) );
+                child = &mEntries.back();
+
+                // the key refers to the label owned by the child entry.
+                ChildKey key;
+                key.mParent = entry;
+                key.mLabel  = child->first.getLabelData( 0 );
+                mChildren.insert( ChildContainer::value_type( key, child ) );
+                if ( label == "*" )
+                    entry->mWildcard = child;
+            }
+            entry = child;
+        }
+        return entry->second;
+    }
+
+    NodeTree::NodePtr NodeTree::find( const Domainname &name ) const
+    {
+        const value_type *node = lookup( name ).mNode;
+        if ( node == nullptr )
+            return NodePtr();
+        return node->second;
+    }
+
+    NodeTree::LookupResult NodeTree::lookup( const Domainname &name ) const
+    {
+        LookupResult result;
+        if ( ! mApex.isSubDomain( name ) )
+            return result;
+
+        const Entry *entry = &mEntries.front();
+        for ( int i = name.getLabelCount() - mApex.getLabelCount() - 1 ; i >= 0 ; i-- ) {
+            if ( entry->mWildcard )
+                result.mWildcard = entry->mWildcard;
+
+            entry = findChild( entry, name.getLabelData( i ) );
+            if ( entry == nullptr )
+                break;
+            result.mClosestEncloser = entry;
+            if ( result.mDelegation == nullptr && entry->second->exist( TYPE_NS ) )
+                result.mDelegation = entry;
+            if ( result.mDNAME == nullptr && entry->second->exist( TYPE_DNAME ) )
+                result.mDNAME = entry;
+        }
+
+        if ( result.mClosestEncloser == nullptr )
+            result.mClosestEncloser = &mEntries.front();
+        if ( entry != nullptr )
+            result.mNode = entry;
+        return result;
+    }
+}
@@ -0,0 +1,103 @@
+#ifndef NODETREE_HPP
+#define NODETREE_HPP
+
+#include "zone.hpp"
+#include "arena.hpp"
+#include <boost/noncopyable.hpp>
+#include <deque>
+#include <string>
+#include <unordered_map>
+
+namespace dns
+{
+    /*!
+     * label tree of zone nodes under the apex.
+     * A child node is found by a hash table keyed by its parent and its label ignoring case,
+     * so a lookup descends from the apex with one hash lookup per label, and reports
+     * the closest encloser, delegation point, DNAME and wildcard node on the way.
+     * Nodes are iterated in insertion order, and they are allocated from the arena
+     * ( the RRSet vector in each node still uses the heap ).
+     */
+    class NodeTree : private boost::noncopyable
+    {
+    public:
+        typedef std::shared_ptr<Node>          NodePtr;
+        typedef std::pair<Domainname, NodePtr> value_type;
+
+    private:
+        struct Entry : public value_type {
+            Entry *mWildcard; // child "*", or NULL
+
+            Entry( const Domainname &name, const NodePtr &node )
+                : value_type( name, node ), mWildcard( nullptr )
+            {}
+        };
+
+        /*!
+         * label of a child compared ignoring case. mLabel refers to the wire format label in the name
+         * of the child entry, or in the queried name while looking up, so that keys do not allocate memory.
+         */
+        struct ChildKey {
+            const Entry   *mParent;
+            const uint8_t *mLabel;
+
+            bool operator==( const ChildKey &rhs ) const;
+        };
+
+        struct ChildKeyHash {
+            size_t operator()( const ChildKey &key ) const;
+        };
+
+        typedef std::unordered_map<ChildKey, Entry *, ChildKeyHash> ChildContainer;
+
+        Domainname        mApex;
+        utils::ArenaPtr   mArena;
+        std::deque<Entry> mEntries;   // mEntries[0] is the apex
+        ChildContainer    mChildren;
+
+        NodePtr newNode() const;
+        Entry *findChild( const Entry *parent, const uint8_t *label ) const;
+
+    public:
+        typedef std::deque<Entry>::const_iterator const_iterator;
+
+        /*!
+         * result of lookup(). Pointers refer to nodes in the tree, and they are NULL if not found.
+         */
+        struct LookupResult {
+            const value_type *mNode;            // node of the name
+            const value_type *mClosestEncloser; // deepest existing node among the name and its ancestors
+            const value_type *mDelegation;      // topmost node below the apex which has NS RRSet
+            const value_type *mDNAME;           // topmost node below the apex which has DNAME RRSet
+            const value_type *mWildcard;        // "*" node under the deepest strict ancestor which has one
+
+            LookupResult()
+                : mNode( nullptr ), mClosestEncloser( nullptr ), mDelegation( nullptr ), mDNAME( nullptr ), mWildcard( nullptr )
+            {}
+        };
+
+        /*!
+         * @param arena arena for nodes. A new arena is used if it is NULL.
+         */
+        NodeTree( const Domainname &apex, const utils::ArenaPtr &arena = utils::ArenaPtr() );
+
+        /*!
+         * add the node of the name and empty non-terminal nodes between the apex and the name.
+         * @return node of the name.
+         */
+        NodePtr add( const Domainname &name );
+
+        /*!
+         * @return node of the name, or NULL.
+         */
+        NodePtr find( const Domainname &name ) const;
+
+        LookupResult lookup( const Domainname &name ) const;
+
+        const_iterator begin() const { return mEntries.begin(); }
+        const_iterator end() const   { return mEntries.end(); }
+        size_t size() const { return mEntries.size(); }
+    };
+}
+
+#endif
@@ -113,6 +113,7 @@ int main( int argc, char **argv )
     param.mBindAddress = bind_address;
     param.mBindPort = bind_port;
     param.mThreadCount = thread_count;
+    param.mModifyResponses = true;
     NXNSAttackServer server( param, ns_count, target );
     server.start();
 
@@ -109,12 +109,7 @@ namespace dns
 
     void NSEC3DB::addNode( const Domainname &original, const Node &node )
     {
-	std::vector<Type> types;
-	for ( auto rrset = node.begin() ; rrset != node.end() ; rrset++ ) {
-	    types.push_back( rrset->second->getType() );
-	}
-
-	addNodeToContainer( mNSEC3Entries, original, types );
+	addNodeToContainer( mNSEC3Entries, original, node.getTypes() );
     }
 
     void NSEC3DB::addEmptyNonTerminals()
@@ -1,15 +1,16 @@
 #include "nsecdb.hpp"
 #include "zonesignerimp.hpp"
+#include <algorithm>
 
 namespace dns
 {
 
     void NSECDB::addNode( const Domainname &owner, const Node &node )
     {
-	std::vector<Type> types;
-	for ( auto rrset = node.begin() ; rrset != node.end() ; rrset++ ) {
-	    types.push_back( rrset->second->getType() );
-	}
+        if ( mFrozen )
+            throw std::logic_error( "cannot add node to frozen NSECDB" );
+
+	std::vector<Type> types = node.getTypes();
 	types.push_back( TYPE_NSEC );
 	types.push_back( TYPE_RRSIG );
 
@@ -25,51 +26,51 @@ namespace dns
 	}
     }
 
+    void NSECDB::freeze( TTL ttl )
+    {
+        mChain.clear();
+        mChain.reserve( mNSECEntries.size() );
+        for ( auto nsec_entry = mNSECEntries.begin() ; nsec_entry != mNSECEntries.end() ; nsec_entry++ ) {
+            auto next_entry = nsec_entry;
+            next_entry++;
+            if ( next_entry == mNSECEntries.end() )
+                next_entry = mNSECEntries.begin();
 
-    ResourceRecord NSECDB::find( const Domainname &name, TTL ttl ) const
+            RRSetPtr rrset( new RRSet( nsec_entry->first.getCanonicalDomainname(), CLASS_IN, TYPE_NSEC, ttl ) );
+            rrset->add( RDATAPtr( new RecordNSEC( next_entry->first.getCanonicalDomainname(), nsec_entry->second ) ) );
+            rrset->compile();
+            mChain.push_back( rrset );
+        }
+        mNSECEntries.clear();
+        mFrozen = true;
+    }
+
+    NSECDB::RRSetPtr NSECDB::findRRSet( const Domainname &name ) const
     {
-        if ( mNSECEntries.empty() )
+        if ( ! mFrozen )
+            throw std::logic_error( "NSECDB is not frozen" );
+        if ( mChain.empty() )
             throw std::logic_error( "nsec must not be empty" );
 
-	Domainname owner, next_name;
-	std::vector<Type> types;
-	auto nsec_entry = mNSECEntries.lower_bound( name );
+        // the last NSEC whose owner is not greater than the name, or the last one of the chain.
+        auto nsec = std::upper_bound( mChain.begin(), mChain.end(), name,
+                                      []( const Domainname &lhs, const RRSetPtr &rhs ) { return lhs < rhs->getOwner(); } );
+        if ( nsec == mChain.begin() )
+            nsec = mChain.end();
+        nsec--;
+        return *nsec;
+    }
 
-        if ( nsec_entry == mNSECEntries.end() ) {
-            nsec_entry--;
-	    owner = nsec_entry->first.getCanonicalDomainname();
-	    types = nsec_entry->second;
-	    next_name = mNSECEntries.begin()->first.getCanonicalDomainname();
-        }
-        else if ( nsec_entry->first == name ) {
-	    owner = nsec_entry->first.getCanonicalDomainname();
-	    types = nsec_entry->second;
-            nsec_entry++;
-            if ( nsec_entry == mNSECEntries.end() )
-                nsec_entry = mNSECEntries.begin();
-	    next_name = nsec_entry->first.getCanonicalDomainname();
-        }
-        else if ( nsec_entry == mNSECEntries.begin() ) {
-	    auto last = mNSECEntries.end();
-	    last--;
-	    owner = last->first.getCanonicalDomainname();
-	    types = last->second;
-	    next_name = mNSECEntries.begin()->first.getCanonicalDomainname();
-        }
-        else {
-	    next_name = nsec_entry->first.getCanonicalDomainname();
-            nsec_entry--;
-	    owner = nsec_entry->first.getCanonicalDomainname();
-	    types = nsec_entry->second;
-        }
+    ResourceRecord NSECDB::find( const Domainname &name, TTL ttl ) const
+    {
+        RRSetPtr rrset = findRRSet( name );
 
 	ResourceRecord rr;
-	rr.mDomainname = owner;
+	rr.mDomainname = rrset->getOwner();
 	rr.mClass      = CLASS_IN;
 	rr.mType       = TYPE_NSEC;
 	rr.mTTL        = ttl;
-	rr.mRData      = RDATAPtr( new RecordNSEC( next_name, types ) );
+	rr.mRData      = (*rrset)[0];
 	return rr;
     }
 }
-
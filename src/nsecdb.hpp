@@ -17,19 +17,42 @@ namespace dns
 
     typedef std::shared_ptr<NSECStorable> NSECDBPtr;
     
+    /*!
+     * NSEC chain of a zone.
+     * Nodes are added while the zone is set up, and freeze() builds the NSEC RRSets of the chain
+     * into a vector sorted by owner. After that, find() is a binary search over the vector.
+     */
     class NSECDB : public NSECStorable
     {
 	typedef std::map<Domainname, std::vector<Type>> Container;
     public:
+        typedef std::shared_ptr<RRSet> RRSetPtr;
+
 	NSECDB( const Domainname &apex )
-	    : mApex( apex )
+	    : mApex( apex ), mFrozen( false )
 	{}
 
 	void addNode( const Domainname &name, const Node &node );
+
+        /*!
+         * build precompiled NSEC RRSets with the TTL. Nodes cannot be added after that.
+         */
+        void freeze( TTL ttl );
+        bool isFrozen() const { return mFrozen; }
+
 	ResourceRecord find( const Domainname &name, TTL ttl ) const;
+
+        /*!
+         * @return NSEC RRSet which matches or covers the name. The RRSet is shared by all queries,
+         *         so that its RRSIG can be stored by RRSet::setRRSIG().
+         * @throw std::logic_error if the chain is not frozen or empty.
+         */
+        RRSetPtr findRRSet( const Domainname &name ) const;
     private:
-	Domainname mApex;
-	Container  mNSECEntries;
+	Domainname            mApex;
+	Container             mNSECEntries;
+        std::vector<RRSetPtr> mChain;   // NSEC RRSets sorted by owner
+        bool                  mFrozen;
     };
 
 }
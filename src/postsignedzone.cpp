@@ -19,6 +19,11 @@ namespace dns
 	return mImp->getAnswer( query );
     }
 
+    MessageInfo PostSignedZone::getAnswer( const MessageView &query ) const
+    {
+	return mImp->getAnswer( query );
+    }
+
     PostSignedZone::NodePtr PostSignedZone::findNode( const Domainname &domainname ) const
     {
         return mImp->findNode( domainname );
@@ -39,6 +44,21 @@ namespace dns
 	mImp->verify();
     }
 
+    void PostSignedZone::enableResponseCache( unsigned int capacity )
+    {
+	mImp->enableResponseCache( capacity );
+    }
+
+    ResponseCache *PostSignedZone::getResponseCache() const
+    {
+	return mImp->getResponseCache();
+    }
+
+    utils::ArenaPtr PostSignedZone::getArena() const
+    {
+	return mImp->getArena();
+    }
+
     void PostSignedZone::setup()
     {
 	mImp->setup();
@@ -49,6 +69,11 @@ namespace dns
         return mImp->signRRSet( rrset );
     }
 
+    void PostSignedZone::setSignatureCacheSize( unsigned int capacity )
+    {
+	mImp->setSignatureCacheSize( capacity );
+    }
+
     void PostSignedZone::initialize()
     {
         PostSignedZoneImp::initialize();
@@ -55,22 +55,16 @@ namespace dns
     }
 
 
-    void PostSignedZoneImp::responseNXDomain( const Domainname &qname, MessageInfo &response ) const
+    void PostSignedZoneImp::responseNXDomain( const Domainname &qname, MessageInfo &response, const NodeTree::LookupResult &result ) const
     {
 	response.mResponseCode = NXDOMAIN;
 	addSOAToAuthoritySection( response );
 	if ( response.isDNSSECOK() ) {
             if ( mEnableNSEC3 ) {
-                Domainname closest = qname;
-                closest.popSubdomain();
-                Domainname next    = qname;
-                while ( true ) {
-                    NodePtr closest_node = findNode( closest );
-                    if ( closest_node )
-                        break;
-                    closest.popSubdomain();
+                const Domainname &closest = result.mClosestEncloser->first;
+                Domainname next = qname;
+                while ( next.getLabelCount() > closest.getLabelCount() + 1 )
                     next.popSubdomain();
-                }                
                 auto wildcard = closest;
                 wildcard.pushSubdomain( "*" );
 
@@ -120,10 +114,10 @@ namespace dns
 	}
     }
 
-    void PostSignedZoneImp::responseRRSIG( const Domainname &qname, MessageInfo &response ) const
+    void PostSignedZoneImp::responseRRSIG( const Domainname &qname, MessageInfo &response, const NodeTree::LookupResult &result ) const
     {
-	auto node = findNode( qname );
-	if ( node ) {
+	if ( result.mNode ) {
+	    auto node = result.mNode->second;
 	    if ( node->exist() ) {
 		for ( auto rrset_itr = node->begin() ; rrset_itr != node->end() ; rrset_itr++ ) {
 		    auto rrset = *(rrset_itr->second);
@@ -137,19 +131,16 @@ namespace dns
 	}
 	else {
 	    // NXDOMAIN
-	    responseNXDomain( qname, response );
+	    responseNXDomain( qname, response, result );
 	}
     }
 
-    void PostSignedZoneImp::responseNSEC( const Domainname &qname, MessageInfo &response ) const
+    void PostSignedZoneImp::responseNSEC( const Domainname &qname, MessageInfo &response, const NodeTree::LookupResult &result ) const
     {
-	auto node = findNode( qname );
-	if ( node ) {
+	if ( result.mNode ) {
+	    auto node = result.mNode->second;
 	    if ( node->exist() ) {
-                ResourceRecord nsec_rr = mNSECDB.find( qname, getSOA().getTTL() );
-                RRSetPtr rrset( new RRSet( nsec_rr.mDomainname, nsec_rr.mClass, nsec_rr.mType, nsec_rr.mTTL ) );
-                rrset->add( nsec_rr.mRData );
-
+                RRSetPtr rrset = mNSECDB.findRRSet( qname );
                 addRRSet( response.mAnswerSection, *rrset );
                 addRRSIG( response, response.mAnswerSection, *rrset );
 	    }
@@ -159,7 +150,7 @@ namespace dns
 	}
 	else {
 	    // NXDOMAIN
-	    responseNXDomain( qname, response );
+	    responseNXDomain( qname, response, result );
 	}
     }
     
@@ -176,6 +167,7 @@ namespace dns
 	    mNSECDB.addNode( node->first, *(node->second) );
 	    mNSEC3DB.addNode( node->first, *(node->second) );
 	}
+        mNSECDB.freeze( getSOA().getTTL() );
     }
 
     PostSignedZoneImp::RRSetPtr PostSignedZoneImp::getDNSKEYRRSet() const
@@ -197,11 +189,7 @@ namespace dns
     
     PostSignedZoneImp::RRSetPtr PostSignedZoneImp::generateNSECRRSet( const Domainname &domainname ) const
     {
-	ResourceRecord nsec_rr = mNSECDB.find( domainname, getSOA().getTTL() );
-	RRSetPtr rrset( new RRSet( nsec_rr.mDomainname, nsec_rr.mClass, nsec_rr.mType, nsec_rr.mTTL ) );
-	rrset->add( nsec_rr.mRData );
-
-	return rrset;
+	return mNSECDB.findRRSet( domainname );
     }
 
     std::shared_ptr<RRSet> PostSignedZoneImp::signRRSet( const RRSet &rrset ) const
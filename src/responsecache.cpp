@@ -0,0 +1,124 @@
+#include "responsecache.hpp"
+#include <cstring>
+
+namespace dns
+{
+    static const unsigned int HEADER_SIZE = sizeof( PacketHeaderField );
+
+    ResponseCache::ResponseCache( unsigned int capacity, unsigned int max_age, unsigned int shard_count )
+        : mShardCapacity( std::max( 1u, capacity / shard_count ) ), mMaxAge( max_age )
+    {
+        for ( unsigned int i = 0 ; i < shard_count ; i++ )
+            mShards.push_back( std::unique_ptr<Shard>( new Shard ) );
+    }
+
+    bool ResponseCache::isCacheable( const MessageView &query )
+    {
+        if ( query.getQueryResponse() != 0 || query.getOpcode() != OPCODE_QUERY )
+            return false;
+        if ( query.getQuestionCount() != 1 || query.getAnswerCount() != 0 || query.getAuthorityCount() != 0 )
+            return false;
+        if ( query.getAdditionalCount() != ( query.isEDNS0() ? 1 : 0 ) )
+            return false;
+        return ! query.isEDNS0() || query.getEDNSVersion() == 0;
+    }
+
+    bool ResponseCache::generateKey( const MessageView &query, std::string &key, unsigned int &qname_length )
+    {
+        if ( ! isCacheable( query ) )
+            return false;
+
+        // QNAME of the first question is never compressed in a valid query.
+        const uint8_t *qname = query.getQuestionPosition();
+        if ( qname != query.begin() + HEADER_SIZE )
+            return false;
+        unsigned int pos = 0;
+        while ( qname[ pos ] != 0 ) {
+            if ( qname[ pos ] & 0xc0 )
+                return false;
+            pos += qname[ pos ] + 1;
+        }
+        qname_length = pos + 1;
+
+        key.reserve( qname_length + 7 );
+        for ( unsigned int i = 0 ; i < qname_length ; i++ ) {
+            uint8_t c = qname[ i ];
+            key.push_back( 'A' <= c && c <= 'Z' ? c + ( 'a' - 'A' ) : c );
+        }
+
+        // QTYPE and QCLASS
+        const uint8_t *qtype = qname + qname_length;
+        key.append( reinterpret_cast<const char *>( qtype ), 4 );
+
+        uint16_t payload_size = query.isEDNS0() ? query.getPayloadSize() : 0;
+        key.push_back( ( query.isEDNS0() ? 0x01 : 0 ) | ( query.isDNSSECOK() ? 0x02 : 0 ) );
+        key.push_back( payload_size >> 8 );
+        key.push_back( payload_size & 0xff );
+        return true;
+    }
+
+    ResponseCache::Shard &ResponseCache::getShard( const std::string &key ) const
+    {
+        return *mShards[ std::hash<std::string>()( key ) % mShards.size() ];
+    }
+
+    bool ResponseCache::find( const MessageView &query, WireFormat &response ) const
+    {
+        std::string  key;
+        unsigned int qname_length;
+        if ( ! generateKey( query, key, qname_length ) )
+            return false;
+
+        Shard &shard = getShard( key );
+        {
+            boost::mutex::scoped_lock lock( shard.mMutex );
+            auto entry = shard.mEntries.find( key );
+            if ( entry == shard.mEntries.end() )
+                return false;
+            if ( entry->second.mExpiration <= time( nullptr ) ) {
+                shard.mEntries.erase( entry );
+                return false;
+            }
+            response.clear();
+            response.pushBuffer( entry->second.mResponse );
+        }
+
+        // patch ID, RD, CD and QNAME.
+        const uint8_t *query_data = query.begin();
+        response[ 0 ] = query_data[ 0 ];
+        response[ 1 ] = query_data[ 1 ];
+        response[ 2 ] = ( response[ 2 ] & ~0x01 ) | ( query_data[ 2 ] & 0x01 );
+        response[ 3 ] = ( response[ 3 ] & ~0x10 ) | ( query_data[ 3 ] & 0x10 );
+        for ( unsigned int i = 0 ; i < qname_length ; i++ )
+            response[ HEADER_SIZE + i ] = query_data[ HEADER_SIZE + i ];
+        return true;
+    }
+
+    void ResponseCache::insert( const MessageView &query, const WireFormat &response )
+    {
+        std::string  key;
+        unsigned int qname_length;
+        if ( ! generateKey( query, key, qname_length ) )
+            return;
+        if ( response.size() < HEADER_SIZE + qname_length + 4 || response[ 4 ] != 0 || response[ 5 ] != 1 )
+            return;
+
+        Entry entry;
+        entry.mResponse   = response.get();
+        entry.mExpiration = time( nullptr ) + mMaxAge;
+
+        Shard &shard = getShard( key );
+        boost::mutex::scoped_lock lock( shard.mMutex );
+        if ( shard.mEntries.size() >= mShardCapacity && shard.mEntries.find( key ) == shard.mEntries.end() )
+            shard.mEntries.erase( shard.mEntries.begin() );
+        shard.mEntries[ key ] = entry;
+    }
+
+    void ResponseCache::clear()
+    {
+        for ( auto &shard : mShards ) {
+            boost::mutex::scoped_lock lock( shard->mMutex );
+            shard->mEntries.clear();
+        }
+    }
+}
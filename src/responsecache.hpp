@@ -0,0 +1,63 @@
+#ifndef RESPONSECACHE_HPP
+#define RESPONSECACHE_HPP
+
+#include "messageview.hpp"
+#include <boost/noncopyable.hpp>
+#include <boost/thread.hpp>
+#include <ctime>
+#include <memory>
+#include <unordered_map>
+
+namespace dns
+{
+    /*!
+     * cache of responses in wire format keyed by QNAME(ignoring case), QTYPE, QCLASS and EDNS0 parameters.
+     * A cached response is copied with ID, RD, CD and QNAME of the query, so the letter case of QNAME is kept.
+     * Entries are distributed to shards by the hash of the key, and each shard has its own lock.
+     * Entries expire after max_age seconds, so that signatures in responses are refreshed.
+     */
+    class ResponseCache : private boost::noncopyable
+    {
+    public:
+        ResponseCache( unsigned int capacity, unsigned int max_age = 60, unsigned int shard_count = 16 );
+
+        /*!
+         * copy the cached response for the query to response.
+         * @return false if the query is not cacheable or the response is not cached.
+         */
+        bool find( const MessageView &query, WireFormat &response ) const;
+
+        /*!
+         * cache the response generated for the query.
+         * the response must be generated from the query, and begin with its question.
+         */
+        void insert( const MessageView &query, const WireFormat &response );
+
+        void clear();
+
+        /*!
+         * @return true if the response depends only on the key and the patched fields.
+         */
+        static bool isCacheable( const MessageView &query );
+
+    private:
+        struct Entry {
+            PacketData mResponse;
+            time_t     mExpiration;
+        };
+
+        struct Shard {
+            boost::mutex                           mMutex;
+            std::unordered_map<std::string, Entry> mEntries;
+        };
+
+        std::vector<std::unique_ptr<Shard>> mShards;
+        unsigned int                        mShardCapacity;
+        unsigned int                        mMaxAge;
+
+        static bool generateKey( const MessageView &query, std::string &key, unsigned int &qname_length );
+        Shard &getShard( const std::string &key ) const;
+    };
+}
+
+#endif
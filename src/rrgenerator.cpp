@@ -100,7 +100,7 @@ namespace dns
             return result;
         case 1: // erase labels;
             {
-                unsigned int erased_label_count = getRandom( hint.getLabels().size() );
+                unsigned int erased_label_count = getRandom( hint.getLabelCount() );
                 for ( unsigned int i = 0 ; i < erased_label_count ; i++ ) {
                     result.popSubdomain();
                 }
@@ -109,8 +109,8 @@ namespace dns
             }
         case 2: // append labels as subdomain;
             {
-                unsigned int label_count        = hint.getLabels().size();
-                unsigned int append_label_count = getRandom( 255 - hint.getLabels().size() );
+                unsigned int label_count        = hint.getLabelCount();
+                unsigned int append_label_count = getRandom( 255 - hint.getLabelCount() );
                 unsigned int domainname_size    = hint.size();
                 for ( unsigned int i = 0 ; i < append_label_count ; i++ ) {
                     std::string new_label = generateLabel();
@@ -125,13 +125,13 @@ namespace dns
             }
         case 3: // replace labels;
             {
-                unsigned int erased_label_count = getRandom( hint.getLabels().size() );
+                unsigned int erased_label_count = getRandom( hint.getLabelCount() );
                 for ( unsigned int i = 0 ; i < erased_label_count ; i++ ) {
                     result.popSubdomain();
                 }
 
-                unsigned int label_count        = result.getLabels().size();
-                unsigned int append_label_count = getRandom( 255 - result.getLabels().size() );
+                unsigned int label_count        = result.getLabelCount();
+                unsigned int append_label_count = getRandom( 255 - result.getLabelCount() );
                 unsigned int domainname_size    = result.size();
                 for ( unsigned int i = 0 ; i < append_label_count ; i++ ) {
                     std::string new_label = generateLabel();
@@ -259,7 +259,7 @@ namespace dns
      **********************************************************/
     std::shared_ptr<RDATA> AGenerator::generate( const MessageInfo &hint, const Domainname &hint2 )
     {
-        std::vector<std::shared_ptr<RDATA> > record_a_list;
+        std::vector<ConstRDATAPtr> record_a_list;
         for ( auto rr : hint.getAnswerSection() ) {
             if ( rr.mType == TYPE_A ) {
                 record_a_list.push_back( rr.mRData );
@@ -321,7 +321,7 @@ namespace dns
      **********************************************************/
     std::shared_ptr<RDATA> AAAAGenerator::generate( const MessageInfo &hint1, const Domainname &hint2 )
     {
-        std::vector<std::shared_ptr<RDATA> > record_a_list;
+        std::vector<ConstRDATAPtr> record_a_list;
         for ( auto rr : hint1.getAnswerSection() ) {
             if ( rr.mType == TYPE_AAAA ) {
                 record_a_list.push_back( rr.mRData );
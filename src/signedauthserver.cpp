@@ -25,9 +25,13 @@ namespace dns
         zone.reset( new SignedZone( Domainname( apex ), ksk_config, zsk_config,
                                     salt, iterate, algo,
                                     enable_nsec, enable_nsec3 ) );
+        zone->setSignatureCacheSize( getServerParameters().mSignatureCacheSize );
+        zone->setPresign( getServerParameters().mPresignZone );
 	dns::full::load( *zone, Domainname( apex ), config );
         zone->setup();
 	zone->verify();
+        if ( getServerParameters().mResponseCacheSize > 0 )
+            zone->enableResponseCache( getServerParameters().mResponseCacheSize );
     }
 
     std::vector<std::shared_ptr<RecordDS>> SignedAuthServer::getDSRecords() const
@@ -42,6 +46,19 @@ namespace dns
 	return modifyResponse( query, response, via_tcp );
     }
 
+    bool SignedAuthServer::generateResponse( const dns::MessageView &query, bool via_tcp, dns::MessageInfo &response ) const
+    {
+	if ( hasModifyHooks() )
+	    return false;
+	response = zone->getAnswer( query );
+	return true;
+    }
+
+    ResponseCache *SignedAuthServer::getResponseCache() const
+    {
+	return zone ? zone->getResponseCache() : nullptr;
+    }
+
     MessageInfo SignedAuthServer::modifyResponse( const dns::MessageInfo &query,
 						  const dns::MessageInfo &original_response,
 						  bool via_tcp ) const
@@ -21,6 +21,11 @@ namespace dns
 	return mImp->getAnswer( query );
     }
 
+    MessageInfo SignedZone::getAnswer( const MessageView &query ) const
+    {
+	return mImp->getAnswer( query );
+    }
+
     SignedZone::RRSetPtr SignedZone::findRRSet( const Domainname &domainname, Type type ) const
     {
         return mImp->findRRSet( domainname, type );
@@ -36,6 +41,21 @@ namespace dns
 	mImp->verify();
     }
 
+    void SignedZone::enableResponseCache( unsigned int capacity )
+    {
+	mImp->enableResponseCache( capacity );
+    }
+
+    ResponseCache *SignedZone::getResponseCache() const
+    {
+	return mImp->getResponseCache();
+    }
+
+    utils::ArenaPtr SignedZone::getArena() const
+    {
+	return mImp->getArena();
+    }
+
     void SignedZone::setup()
     {
 	mImp->setup();
@@ -51,6 +71,16 @@ namespace dns
         return mImp->signRRSet( rrset );
     }
 
+    void SignedZone::setSignatureCacheSize( unsigned int capacity )
+    {
+	mImp->setSignatureCacheSize( capacity );
+    }
+
+    void SignedZone::setPresign( bool presign )
+    {
+	mImp->setPresign( presign );
+    }
+
     void SignedZone::initialize()
     {
         SignedZoneImp::initialize();
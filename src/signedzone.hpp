@@ -17,12 +17,18 @@ namespace dns
 
         void add( std::shared_ptr<RRSet> rrset );
         MessageInfo getAnswer( const MessageInfo &query ) const;
+        MessageInfo getAnswer( const MessageView &query ) const;
         NodePtr  findNode( const Domainname &domainname ) const;
         RRSetPtr findRRSet( const Domainname &domainname, Type type ) const;
 	std::vector<std::shared_ptr<RecordDS>> getDSRecords() const; 
         void verify() const;
+        void enableResponseCache( unsigned int capacity );
+        ResponseCache *getResponseCache() const;
+        utils::ArenaPtr getArena() const;
         void setup();
         std::shared_ptr<RRSet> signRRSet( const RRSet &rrset );
+        void setSignatureCacheSize( unsigned int capacity );
+        void setPresign( bool presign );
 
         static void initialize();
     private:
@@ -12,7 +12,7 @@ namespace dns
         : AbstractZoneImp( zone_name ), mSigner( zone_name, ksk_config, zsk_config ),
           mNSECDB( new NSECDB( zone_name ) ),
           mNSEC3DB( new NSEC3DB( zone_name, salt, iterate, algo ) ),
-          mEnableNSEC( enable_nsec ), mEnableNSEC3( enable_nsec3 )
+          mEnableNSEC( enable_nsec ), mEnableNSEC3( enable_nsec3 ), mPresign( false )
     {}
 
 
@@ -50,7 +50,7 @@ namespace dns
     }
 
 
-    void SignedZoneImp::responseNXDomain( const Domainname &qname, MessageInfo &response ) const
+    void SignedZoneImp::responseNXDomain( const Domainname &qname, MessageInfo &response, const NodeTree::LookupResult &result ) const
     {
 	response.mResponseCode = NXDOMAIN;
 	addSOAToAuthoritySection( response );
@@ -83,26 +83,23 @@ namespace dns
 
     void SignedZoneImp::responseDNSKEY( const Domainname &qname, MessageInfo &response ) const
     {
-	std::vector<std::shared_ptr<RecordDNSKEY>> keys = mSigner.getDNSKEYRecords();
-	std::shared_ptr<RRSet> dnskey_rrset( new RRSet( getSOA().getOwner(), getSOA().getClass(), TYPE_DNSKEY, getSOA().getTTL() ) );
-	for ( auto k : keys ) {
-	    dnskey_rrset->add( k );
-	}
+	std::shared_ptr<RRSet> dnskey_rrset = findRRSet( getApex(), TYPE_DNSKEY );
+	if ( ! dnskey_rrset )
+	    dnskey_rrset = getDNSKEYRRSet();
 	addRRSet( response.mAnswerSection, *dnskey_rrset );
 	if ( response.isDNSSECOK() ) {
-	    std::shared_ptr<RRSet> rrsig_rrset = mSigner.signDNSKEY( getSOA().getTTL() );
+	    std::shared_ptr<RRSet> rrsig_rrset = signRRSet( *dnskey_rrset );
 	    addRRSet( response.mAnswerSection, *rrsig_rrset );
 	}
     }
 
-    void SignedZoneImp::responseRRSIG( const Domainname &qname, MessageInfo &response ) const
+    void SignedZoneImp::responseRRSIG( const Domainname &qname, MessageInfo &response, const NodeTree::LookupResult &result ) const
     {
-	auto node = findNode( qname );
-	if ( node ) {
+	if ( result.mNode ) {
+	    auto node = result.mNode->second;
 	    if ( node->exist() ) {
 		for ( auto rrset_itr = node->begin() ; rrset_itr != node->end() ; rrset_itr++ ) {
-		    auto rrset = *(rrset_itr->second);
-		    std::shared_ptr<RRSet> rrsig = mSigner.signRRSet( rrset );
+		    std::shared_ptr<RRSet> rrsig = getRRSIGRRSet( *(rrset_itr->second) );
 		    addRRSet( response.mAnswerSection, *rrsig );
 		}
 	    }
@@ -112,19 +109,16 @@ namespace dns
 	}
 	else {
 	    // NXDOMAIN
-	    responseNXDomain( qname, response );
+	    responseNXDomain( qname, response, result );
 	}
     }
 
-    void SignedZoneImp::responseNSEC( const Domainname &qname, MessageInfo &response ) const
+    void SignedZoneImp::responseNSEC( const Domainname &qname, MessageInfo &response, const NodeTree::LookupResult &result ) const
     {
-	auto node = findNode( qname );
-	if ( node ) {
+	if ( result.mNode ) {
+	    auto node = result.mNode->second;
 	    if ( node->exist() ) {
-                ResourceRecord nsec_rr = mNSECDB->find( qname, getSOA().getTTL() );
-                RRSetPtr rrset( new RRSet( nsec_rr.mDomainname, nsec_rr.mClass, nsec_rr.mType, nsec_rr.mTTL ) );
-                rrset->add( nsec_rr.mRData );
-
+                RRSetPtr rrset = mNSECDB->findRRSet( qname );
                 addRRSet( response.mAnswerSection, *rrset );
                 addRRSIG( response, response.mAnswerSection, *rrset );
 	    }
@@ -134,7 +128,7 @@ namespace dns
 	}
 	else {
 	    // NXDOMAIN
-	    responseNXDomain( qname, response );
+	    responseNXDomain( qname, response, result );
 	}
     }
     
@@ -151,6 +145,66 @@ namespace dns
 	    mNSECDB->addNode( node->first, *(node->second) );
 	    mNSEC3DB->addNode( node->first, *(node->second) );
 	}
+        mNSECDB->freeze( getSOA().getTTL() );
+        if ( mPresign )
+            presign();
+    }
+
+    void SignedZoneImp::presign()
+    {
+        for ( auto node = begin() ; node != end() ; node++ ) {
+            // NS RRSets of delegation points and records below them( glue ) are not authoritative.
+            const NodeTree::value_type *delegation = lookup( node->first ).mDelegation;
+            bool is_delegation = delegation == &*node;
+            bool is_glue       = delegation != nullptr && ! is_delegation;
+
+            if ( ! is_glue ) {
+                for ( auto rrset = node->second->begin() ; rrset != node->second->end() ; rrset++ ) {
+                    if ( is_delegation && rrset->first != TYPE_DS )
+                        continue;
+                    rrset->second->setRRSIG( signRRSet( *rrset->second ) );
+                }
+            }
+
+            if ( mEnableNSEC ) {
+                // NSEC RRSets are shared by the NSECDB, so the RRSIG is stored in them.
+                RRSetPtr nsec = mNSECDB->findRRSet( node->first );
+                nsec->setRRSIG( mSigner.signRRSet( *nsec ) );
+            }
+            if ( mEnableNSEC3 )
+                presignNSEC( *mNSEC3DB, mSignedNSEC3s, node->first );
+        }
+    }
+
+    void SignedZoneImp::presignNSEC( const NSECStorable &db, NSECContainer &signed_nsecs, const Domainname &name )
+    {
+        // NSEC( NSEC3 ) record of an existing name is owned by the name( hash of the name ).
+        ResourceRecord nsec_rr = db.find( name, getSOA().getTTL() );
+        RRSetPtr rrset( new RRSet( nsec_rr.mDomainname, nsec_rr.mClass, nsec_rr.mType, nsec_rr.mTTL ) );
+        rrset->add( nsec_rr.mRData );
+        rrset->compile();
+        rrset->setRRSIG( mSigner.signRRSet( *rrset ) );
+        signed_nsecs[ nsec_rr.mDomainname ] = rrset;
+    }
+
+    SignedZoneImp::RRSetPtr SignedZoneImp::findNSECRRSet( const NSECStorable &db, const NSECContainer &signed_nsecs, const Domainname &name ) const
+    {
+        ResourceRecord nsec_rr = db.find( name, getSOA().getTTL() );
+        auto signed_nsec = signed_nsecs.find( nsec_rr.mDomainname );
+        if ( signed_nsec != signed_nsecs.end() )
+            return signed_nsec->second;
+
+        RRSetPtr rrset( new RRSet( nsec_rr.mDomainname, nsec_rr.mClass, nsec_rr.mType, nsec_rr.mTTL ) );
+        rrset->add( nsec_rr.mRData );
+        return rrset;
+    }
+
+    SignedZoneImp::RRSetPtr SignedZoneImp::getRRSIGRRSet( const RRSet &rrset ) const
+    {
+        RRSetPtr rrsig = rrset.getRRSIG();
+        if ( rrsig )
+            return rrsig;
+        return mSigner.signRRSet( rrset );
     }
 
     SignedZoneImp::RRSetPtr SignedZoneImp::getDNSKEYRRSet() const
@@ -173,7 +227,7 @@ namespace dns
 	if ( ! response.isDNSSECOK() )
 	    return;
 
-	std::shared_ptr<RRSet> rrsigs = mSigner.signRRSet( original_rrset );
+	std::shared_ptr<RRSet> rrsigs = getRRSIGRRSet( original_rrset );
 	
 	for( auto rrsig : rrsigs->getRRSet() ) {
 	    ResourceRecord r;
@@ -190,11 +244,7 @@ namespace dns
     SignedZoneImp::RRSetPtr SignedZoneImp::generateNSECRRSet( const Domainname &domainname ) const
     {
         if ( mEnableNSEC ) {
-            ResourceRecord nsec_rr = mNSECDB->find( domainname, getSOA().getTTL() );
-            RRSetPtr rrset( new RRSet( nsec_rr.mDomainname, nsec_rr.mClass, nsec_rr.mType, nsec_rr.mTTL ) );
-            rrset->add( nsec_rr.mRData );
-
-            return rrset;
+            return mNSECDB->findRRSet( domainname );
         }
         else {
             return RRSetPtr();
@@ -204,10 +254,7 @@ namespace dns
     SignedZoneImp::RRSetPtr SignedZoneImp::generateNSEC3RRSet( const Domainname &domainname ) const
     {
         if ( mEnableNSEC3 ) {
-            ResourceRecord nsec_rr = mNSEC3DB->find( domainname, getSOA().getTTL() );
-            RRSetPtr rrset( new RRSet( nsec_rr.mDomainname, nsec_rr.mClass, nsec_rr.mType, nsec_rr.mTTL ) );
-            rrset->add( nsec_rr.mRData );
-            return rrset;
+            return findNSECRRSet( *mNSEC3DB, mSignedNSEC3s, domainname );
         }
         else {
             return RRSetPtr();
@@ -216,6 +263,8 @@ namespace dns
 
     std::shared_ptr<RRSet> SignedZoneImp::signRRSet( const RRSet &rrset ) const
     {
+        if ( rrset.getRRSIG() )
+            return rrset.getRRSIG();
         if ( rrset.getType() == TYPE_DNSKEY )
             return mSigner.signDNSKEY( rrset.getTTL() );
         else
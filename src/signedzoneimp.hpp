@@ -10,25 +10,40 @@ namespace dns
     class SignedZoneImp : public AbstractZoneImp
     {
     private:
+        typedef std::map<Domainname, RRSetPtr> NSECContainer;
+
 	ZoneSigner mSigner;
-	NSECDBPtr mNSECDB;
+	std::shared_ptr<NSECDB> mNSECDB;
         NSECDBPtr mNSEC3DB;
         bool mEnableNSEC;
         bool mEnableNSEC3;
+        bool mPresign;
+        NSECContainer mSignedNSEC3s;  // presigned NSEC3 RRSets by owner
+
+        void presign();
+        void presignNSEC( const NSECStorable &db, NSECContainer &signed_nsecs, const Domainname &name );
+        RRSetPtr findNSECRRSet( const NSECStorable &db, const NSECContainer &signed_nsecs, const Domainname &name ) const;
+        RRSetPtr getRRSIGRRSet( const RRSet &rrset ) const;
 
     public:
         SignedZoneImp( const Domainname &zone_name, const std::string &ksk_config, const std::string &zsk_config,
                        const std::vector<uint8_t> &salt, uint16_t iterate, HashAlgorithm alog,
                        bool enable_nsec, bool enable_nsec3 );
 
+        /*!
+         * sign all authoritative RRSets, NSEC/NSEC3 records and DNSKEY RRSet at setup(),
+         * so that responses only attach the stored RRSIGs.
+         */
+        void setPresign( bool presign ) { mPresign = presign; }
         virtual void setup();
 
 	virtual std::vector<std::shared_ptr<RecordDS>> getDSRecords() const;
 	virtual std::shared_ptr<RRSet> signRRSet( const RRSet & ) const;
+        void setSignatureCacheSize( unsigned int capacity ) { mSigner.setSignatureCacheSize( capacity ); }
 	virtual void responseNoData( const Domainname &qname, MessageInfo &response, bool need_wildcard_nsec ) const;
-	virtual void responseNXDomain( const Domainname &qname, MessageInfo &response ) const;
-	virtual void responseRRSIG( const Domainname &qname, MessageInfo &response ) const;
-	virtual void responseNSEC( const Domainname &qname, MessageInfo &response ) const;
+	virtual void responseNXDomain( const Domainname &qname, MessageInfo &response, const NodeTree::LookupResult &result ) const;
+	virtual void responseRRSIG( const Domainname &qname, MessageInfo &response, const NodeTree::LookupResult &result ) const;
+	virtual void responseNSEC( const Domainname &qname, MessageInfo &response, const NodeTree::LookupResult &result ) const;
         virtual void responseDNSKEY( const Domainname &qname, MessageInfo &response ) const;
         virtual void addRRSIG( MessageInfo &, std::vector<ResourceRecord> &, const RRSet &original_rrset ) const;
         virtual void addRRSIG( MessageInfo &, std::vector<ResourceRecord> &, const RRSet &original_rrset, const Domainname &owner ) const;
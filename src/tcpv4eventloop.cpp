@@ -0,0 +1,457 @@
+#include "tcpv4eventloop.hpp"
+#include <cerrno>
+#include <cstring>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace tcpv4
+{
+    const ConnectionID LISTEN_SOCKET_ID    = 0;
+    const ConnectionID WAKEUP_EVENT_ID     = 1;
+    const ConnectionID FIRST_CONNECTION_ID = 2;
+    const int          MAX_EVENTS          = 256;
+    const int          READ_BUFFER_SIZE    = 4096;
+    const int          RETRY_INTERVAL      = 10;   // milliseconds to pass deferred messages again
+    const time_t       ACCEPT_BACKOFF      = 1;    // seconds
+
+    static time_t getMonotonicTime()
+    {
+        timespec now;
+        clock_gettime( CLOCK_MONOTONIC, &now );
+        return now.tv_sec;
+    }
+
+    EventLoop::EventLoop( Server &server, MessageHandler handler, const EventLoopParameters &params )
+        : mServer( server ), mHandler( handler ), mParameters( params ), mEpoll( -1 ), mWakeupEvent( -1 ),
+          mIsContinue( true ), mNextID( FIRST_CONNECTION_ID ), mIsAcceptPaused( false ), mAcceptResumeTime( 0 )
+    {
+        mEpoll = epoll_create1( EPOLL_CLOEXEC );
+        if ( mEpoll < 0 )
+            throw SocketError( getErrorMessage( "cannot create epoll", errno ) );
+
+        mWakeupEvent = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+        if ( mWakeupEvent < 0 ) {
+            close( mEpoll );
+            throw SocketError( getErrorMessage( "cannot create eventfd", errno ) );
+        }
+
+        mServer.setNonBlocking( true );
+
+        epoll_event event;
+        std::memset( &event, 0, sizeof( event ) );
+        event.events   = EPOLLIN;
+        event.data.u64 = LISTEN_SOCKET_ID;
+        if ( epoll_ctl( mEpoll, EPOLL_CTL_ADD, mServer.getSocket(), &event ) < 0 ) {
+            close( mWakeupEvent );
+            close( mEpoll );
+            throw SocketError( getErrorMessage( "cannot add listen socket to epoll", errno ) );
+        }
+
+        event.events   = EPOLLIN;
+        event.data.u64 = WAKEUP_EVENT_ID;
+        if ( epoll_ctl( mEpoll, EPOLL_CTL_ADD, mWakeupEvent, &event ) < 0 ) {
+            close( mWakeupEvent );
+            close( mEpoll );
+            throw SocketError( getErrorMessage( "cannot add eventfd to epoll", errno ) );
+        }
+    }
+
+    EventLoop::~EventLoop()
+    {
+        close( mWakeupEvent );
+        close( mEpoll );
+    }
+
+    void EventLoop::run()
+    {
+        epoll_event events[ MAX_EVENTS ];
+        bool        sweep      = mParameters.mIdleTimeout > 0 || mParameters.mWriteTimeout > 0;
+        time_t      last_sweep = getMonotonicTime();
+
+        while ( mIsContinue ) {
+            int timeout = -1;
+            if ( ! mDeferredConnections.empty() )
+                timeout = RETRY_INTERVAL;
+            else if ( sweep || mIsAcceptPaused )
+                timeout = 1000;
+
+            int event_count = epoll_wait( mEpoll, events, MAX_EVENTS, timeout );
+            if ( event_count < 0 ) {
+                if ( errno == EINTR )
+                    continue;
+                throw SocketError( getErrorMessage( "cannot wait events", errno ) );
+            }
+
+            for ( int i = 0; i < event_count; i++ ) {
+                ConnectionID id = events[ i ].data.u64;
+                if ( id == LISTEN_SOCKET_ID ) {
+                    acceptConnections();
+                    continue;
+                }
+                if ( id == WAKEUP_EVENT_ID ) {
+                    uint64_t counter;
+                    while ( read( mWakeupEvent, &counter, sizeof( counter ) ) > 0 )
+                        ;
+                    processActions();
+                    continue;
+                }
+
+                auto state = mConnections.find( id );
+                if ( state == mConnections.end() )
+                    continue;
+                ConnectionStatePtr conn = state->second;
+
+                if ( events[ i ].events & ( EPOLLERR | EPOLLHUP ) ) {
+                    removeConnection( id );
+                    continue;
+                }
+                if ( events[ i ].events & EPOLLIN )
+                    readMessages( id, *conn );
+                if ( mConnections.count( id ) && ( events[ i ].events & EPOLLOUT ) )
+                    writeMessages( id, *conn );
+            }
+
+            if ( ! mDeferredConnections.empty() )
+                retryDeferredConnections();
+
+            time_t now = getMonotonicTime();
+            if ( mIsAcceptPaused && now >= mAcceptResumeTime )
+                resumeAccepting();
+            if ( sweep && now != last_sweep ) {
+                last_sweep = now;
+                removeInactiveConnections();
+            }
+        }
+
+        for ( auto conn : mConnections )
+            epoll_ctl( mEpoll, EPOLL_CTL_DEL, conn.second->mConnection->getSocket(), NULL );
+        mConnections.clear();
+    }
+
+    void EventLoop::stop()
+    {
+        {
+            boost::unique_lock<boost::mutex> lock( mMutex );
+            mIsContinue = false;
+        }
+        mDetachCondition.notify_all();
+        uint64_t one = 1;
+        write( mWakeupEvent, &one, sizeof( one ) );
+    }
+
+    void EventLoop::sendMessage( ConnectionID id, const WireFormat &message )
+    {
+        Action action;
+        action.mType = SEND_MESSAGE;
+        action.mID   = id;
+        action.mMessage.reserve( message.size() + 2 );
+        action.mMessage.push_back( message.size() >> 8 );
+        action.mMessage.push_back( message.size() & 0xff );
+        message.foreachBuffers( [&action]( const uint8_t *begin, const uint8_t *end ) {
+            action.mMessage.insert( action.mMessage.end(), begin, end );
+        } );
+        postAction( action );
+    }
+
+    void EventLoop::closeConnection( ConnectionID id )
+    {
+        Action action;
+        action.mType = CLOSE_CONNECTION;
+        action.mID   = id;
+        postAction( action );
+    }
+
+    ConnectionPtr EventLoop::detachConnection( ConnectionID id )
+    {
+        Action action;
+        action.mType = DETACH_CONNECTION;
+        action.mID   = id;
+        postAction( action );
+
+        boost::unique_lock<boost::mutex> lock( mMutex );
+        while ( mIsContinue && mDetachedConnections.find( id ) == mDetachedConnections.end() )
+            mDetachCondition.wait( lock );
+
+        auto detached = mDetachedConnections.find( id );
+        if ( detached == mDetachedConnections.end() )
+            return ConnectionPtr();
+        ConnectionPtr conn = detached->second;
+        mDetachedConnections.erase( detached );
+        return conn;
+    }
+
+    void EventLoop::postAction( const Action &action )
+    {
+        {
+            boost::unique_lock<boost::mutex> lock( mMutex );
+            mActions.push_back( action );
+        }
+        uint64_t one = 1;
+        write( mWakeupEvent, &one, sizeof( one ) );
+    }
+
+    void EventLoop::processActions()
+    {
+        std::deque<Action> actions;
+        {
+            boost::unique_lock<boost::mutex> lock( mMutex );
+            actions.swap( mActions );
+        }
+
+        for ( auto &action : actions ) {
+            auto state = mConnections.find( action.mID );
+            ConnectionStatePtr conn;
+            if ( state != mConnections.end() )
+                conn = state->second;
+
+            switch ( action.mType ) {
+            case SEND_MESSAGE:
+                if ( ! conn )
+                    break;
+                if ( conn->mPendingCount > 0 )
+                    conn->mPendingCount--;
+                conn->mLastActive = getMonotonicTime();
+                if ( conn->mSendQueue.empty() )
+                    conn->mLastWritten = conn->mLastActive;
+                conn->mSendQueueSize += action.mMessage.size();
+                conn->mSendQueue.push_back( PacketData() );
+                conn->mSendQueue.back().swap( action.mMessage );
+                // messages waiting for the pipelining limit can be dispatched now.
+                dispatchMessages( action.mID, *conn );
+                writeMessages( action.mID, *conn );
+                break;
+            case CLOSE_CONNECTION:
+                if ( ! conn )
+                    break;
+                conn->mIsClosing = true;
+                updateConnection( action.mID, *conn );
+                break;
+            case DETACH_CONNECTION: {
+                ConnectionPtr detached;
+                if ( conn ) {
+                    detached = conn->mConnection;
+                    epoll_ctl( mEpoll, EPOLL_CTL_DEL, detached->getSocket(), NULL );
+                    mConnections.erase( action.mID );
+                    try {
+                        detached->setNonBlocking( false );
+                    } catch ( SocketError & ) {
+                        detached.reset();
+                    }
+                }
+                {
+                    boost::unique_lock<boost::mutex> lock( mMutex );
+                    mDetachedConnections[ action.mID ] = detached;
+                }
+                mDetachCondition.notify_all();
+                break;
+            }
+            }
+        }
+    }
+
+    void EventLoop::acceptConnections()
+    {
+        while ( true ) {
+            ConnectionPtr new_connection;
+            try {
+                new_connection = mServer.acceptConnection();
+            } catch ( SocketError & ) {
+                int error = errno;
+                // the listen socket stays readable until a file descriptor is freed.
+                if ( error == EMFILE || error == ENFILE || error == ENOBUFS || error == ENOMEM )
+                    pauseAccepting();
+                // connection reset, etc. try again at the next event.
+                return;
+            }
+            if ( ! new_connection )
+                return;
+
+            try {
+                new_connection->setNonBlocking( true );
+            } catch ( SocketError & ) {
+                continue;
+            }
+
+            ConnectionID id = mNextID++;
+            ConnectionStatePtr state = std::make_shared<ConnectionState>( new_connection, getMonotonicTime() );
+
+            epoll_event event;
+            std::memset( &event, 0, sizeof( event ) );
+            event.events   = EPOLLIN;
+            event.data.u64 = id;
+            if ( epoll_ctl( mEpoll, EPOLL_CTL_ADD, new_connection->getSocket(), &event ) < 0 )
+                continue;
+            state->mEvents = event.events;
+            mConnections.insert( std::make_pair( id, state ) );
+        }
+    }
+
+    void EventLoop::pauseAccepting()
+    {
+        epoll_ctl( mEpoll, EPOLL_CTL_DEL, mServer.getSocket(), NULL );
+        mIsAcceptPaused   = true;
+        mAcceptResumeTime = getMonotonicTime() + ACCEPT_BACKOFF;
+    }
+
+    void EventLoop::resumeAccepting()
+    {
+        epoll_event event;
+        std::memset( &event, 0, sizeof( event ) );
+        event.events   = EPOLLIN;
+        event.data.u64 = LISTEN_SOCKET_ID;
+        if ( epoll_ctl( mEpoll, EPOLL_CTL_ADD, mServer.getSocket(), &event ) < 0 ) {
+            mAcceptResumeTime = getMonotonicTime() + ACCEPT_BACKOFF;
+            return;
+        }
+        mIsAcceptPaused = false;
+    }
+
+    void EventLoop::retryDeferredConnections()
+    {
+        std::vector<ConnectionID> deferred_connections;
+        deferred_connections.swap( mDeferredConnections );
+        for ( auto id : deferred_connections ) {
+            auto state = mConnections.find( id );
+            if ( state == mConnections.end() )
+                continue;
+            ConnectionStatePtr conn = state->second;
+            conn->mIsDeferred = false;
+            dispatchMessages( id, *conn );
+            updateConnection( id, *conn );
+        }
+    }
+
+    void EventLoop::readMessages( ConnectionID id, ConnectionState &state )
+    {
+        uint8_t buffer[ READ_BUFFER_SIZE ];
+
+        while ( isReadable( state ) ) {
+            ssize_t recv_size = read( state.mConnection->getSocket(), buffer, sizeof( buffer ) );
+            if ( recv_size < 0 ) {
+                if ( errno == EINTR )
+                    continue;
+                if ( errno == EAGAIN || errno == EWOULDBLOCK )
+                    break;
+                removeConnection( id );
+                return;
+            }
+            if ( recv_size == 0 ) {
+                // peer closed. keep the connection until all responses are sent.
+                state.mIsPeerClosed = true;
+                break;
+            }
+            state.mLastActive = getMonotonicTime();
+            state.mReceiveBuffer.insert( state.mReceiveBuffer.end(), buffer, buffer + recv_size );
+            dispatchMessages( id, state );
+        }
+        updateConnection( id, state );
+    }
+
+    void EventLoop::dispatchMessages( ConnectionID id, ConnectionState &state )
+    {
+        size_t offset = 0;
+        while ( ! state.mIsClosing &&
+                state.mPendingCount < mParameters.mMaxPipelinedMessages &&
+                state.mReceiveBuffer.size() - offset >= 2 ) {
+            uint16_t message_size = ( state.mReceiveBuffer[ offset ] << 8 ) + state.mReceiveBuffer[ offset + 1 ];
+            if ( state.mReceiveBuffer.size() - offset - 2 < message_size )
+                break;
+
+            PacketData message( state.mReceiveBuffer.begin() + offset + 2,
+                                state.mReceiveBuffer.begin() + offset + 2 + message_size );
+            if ( ! mHandler( *this, id, message ) ) {
+                // workers are busy. keep the message, and stop reading the connection until retry.
+                if ( ! state.mIsDeferred ) {
+                    state.mIsDeferred = true;
+                    mDeferredConnections.push_back( id );
+                }
+                break;
+            }
+            offset += 2 + message_size;
+            state.mPendingCount++;
+        }
+        state.mReceiveBuffer.erase( state.mReceiveBuffer.begin(), state.mReceiveBuffer.begin() + offset );
+    }
+
+    void EventLoop::writeMessages( ConnectionID id, ConnectionState &state )
+    {
+        while ( ! state.mSendQueue.empty() ) {
+            const PacketData &message = state.mSendQueue.front();
+            ssize_t sent_size = write( state.mConnection->getSocket(),
+                                       message.data() + state.mSendOffset,
+                                       message.size() - state.mSendOffset );
+            if ( sent_size < 0 ) {
+                if ( errno == EINTR )
+                    continue;
+                if ( errno == EAGAIN || errno == EWOULDBLOCK )
+                    break;
+                removeConnection( id );
+                return;
+            }
+            state.mSendOffset    += sent_size;
+            state.mSendQueueSize -= sent_size;
+            state.mLastWritten    = getMonotonicTime();
+            if ( state.mSendOffset == message.size() ) {
+                state.mSendQueue.pop_front();
+                state.mSendOffset = 0;
+            }
+        }
+        updateConnection( id, state );
+    }
+
+    bool EventLoop::isReadable( const ConnectionState &state ) const
+    {
+        return ! state.mIsPeerClosed && ! state.mIsClosing && ! state.mIsDeferred &&
+            state.mPendingCount < mParameters.mMaxPipelinedMessages &&
+            state.mSendQueueSize < mParameters.mMaxSendQueueSize;
+    }
+
+    void EventLoop::updateConnection( ConnectionID id, ConnectionState &state )
+    {
+        if ( ( state.mIsClosing && state.mSendQueue.empty() ) ||
+             ( state.mIsPeerClosed && state.isIdle() ) ) {
+            removeConnection( id );
+            return;
+        }
+
+        uint32_t events = ( isReadable( state ) ? EPOLLIN : 0 ) | ( state.mSendQueue.empty() ? 0 : EPOLLOUT );
+        if ( events == state.mEvents )
+            return;
+
+        epoll_event event;
+        std::memset( &event, 0, sizeof( event ) );
+        event.events   = events;
+        event.data.u64 = id;
+        epoll_ctl( mEpoll, EPOLL_CTL_MOD, state.mConnection->getSocket(), &event );
+        state.mEvents = events;
+    }
+
+    void EventLoop::removeInactiveConnections()
+    {
+        time_t now = getMonotonicTime();
+        std::vector<ConnectionID> inactive_connections;
+        for ( auto &conn : mConnections ) {
+            const ConnectionState &state = *conn.second;
+            bool is_idle    = mParameters.mIdleTimeout > 0 && state.isIdle() &&
+                now - state.mLastActive >= mParameters.mIdleTimeout;
+            // the peer does not read responses.
+            bool is_stalled = mParameters.mWriteTimeout > 0 && ! state.mSendQueue.empty() &&
+                now - state.mLastWritten >= mParameters.mWriteTimeout;
+            if ( is_idle || is_stalled )
+                inactive_connections.push_back( conn.first );
+        }
+        for ( auto id : inactive_connections )
+            removeConnection( id );
+    }
+
+    void EventLoop::removeConnection( ConnectionID id )
+    {
+        auto state = mConnections.find( id );
+        if ( state == mConnections.end() )
+            return;
+        epoll_ctl( mEpoll, EPOLL_CTL_DEL, state->second->mConnection->getSocket(), NULL );
+        mConnections.erase( state );
+    }
+}
@@ -0,0 +1,153 @@
+#ifndef TCPV4EVENTLOOP_HPP
+#define TCPV4EVENTLOOP_HPP
+
+#include "tcpv4server.hpp"
+#include "wireformat.hpp"
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread.hpp>
+#include <deque>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace tcpv4
+{
+    typedef uint64_t ConnectionID;
+
+    struct EventLoopParameters {
+        unsigned int mIdleTimeout;          // seconds
+        unsigned int mWriteTimeout;         // seconds without progress of sending queued responses
+        unsigned int mMaxPipelinedMessages; // per connection
+        size_t       mMaxSendQueueSize;     // bytes per connection. reading stops while it is exceeded
+
+        EventLoopParameters()
+            : mIdleTimeout( 10 ), mWriteTimeout( 10 ), mMaxPipelinedMessages( 64 ), mMaxSendQueueSize( 256 * 1024 )
+        {}
+    };
+
+    /*!
+     * epoll(7) based event loop which owns connections accepted by Server.
+     * DNS messages prefixed by 2 bytes length are framed incrementally,
+     * and each complete message is passed to MessageHandler.
+     * MessageHandler is called in the event loop thread, so it should pass the message to workers
+     * without blocking. If it returns false( e.g. workers are busy ), the message is passed again later,
+     * and the connection is not read until then.
+     * A connection accepts pipelined messages(RFC 7766), and responses are sent in the order
+     * they become ready. The connection is closed when it is idle for mIdleTimeout seconds.
+     * A client which does not read responses cannot make the server queue them without limit:
+     * reading stops while mMaxSendQueueSize bytes are queued, and the connection is closed
+     * when no queued byte is sent for mWriteTimeout seconds.
+     * When accept(2) fails by the limit of file descriptors, the listen socket is removed from epoll
+     * for a second, so that the loop does not spin.
+     */
+    class EventLoop : private boost::noncopyable
+    {
+    public:
+        typedef boost::function<bool ( EventLoop &, ConnectionID, const PacketData & )> MessageHandler;
+
+        EventLoop( Server &server, MessageHandler handler,
+                   const EventLoopParameters &params = EventLoopParameters() );
+        ~EventLoop();
+
+        /*!
+         * run event loop until stop() is called.
+         */
+        void run();
+        void stop();
+
+        /*!
+         * send the message with 2 bytes length to the connection as the response to a received message.
+         * thread safe. the message is sent by the event loop thread.
+         */
+        void sendMessage( ConnectionID id, const WireFormat &message );
+
+        /*!
+         * close the connection after sending all queued messages.
+         * thread safe.
+         */
+        void closeConnection( ConnectionID id );
+
+        /*!
+         * remove the connection from the event loop and return it in blocking mode.
+         * thread safe. wait until the event loop releases the connection.
+         * queued messages which are not sent yet are discarded.
+         * @return NULL if the connection is already closed.
+         */
+        ConnectionPtr detachConnection( ConnectionID id );
+
+    private:
+        struct ConnectionState {
+            ConnectionPtr          mConnection;
+            PacketData             mReceiveBuffer;
+            std::deque<PacketData> mSendQueue;
+            size_t                 mSendQueueSize; // bytes in mSendQueue which are not sent yet
+            size_t                 mSendOffset;
+            uint32_t               mEvents;
+            unsigned int           mPendingCount;
+            time_t                 mLastActive;
+            time_t                 mLastWritten;   // last time when mSendQueue made progress
+            bool                   mIsPeerClosed;
+            bool                   mIsClosing;
+            bool                   mIsDeferred;    // MessageHandler refused the first message in mReceiveBuffer
+
+            ConnectionState( ConnectionPtr conn, time_t now )
+                : mConnection( conn ), mSendQueueSize( 0 ), mSendOffset( 0 ), mEvents( 0 ), mPendingCount( 0 ),
+                  mLastActive( now ), mLastWritten( now ), mIsPeerClosed( false ), mIsClosing( false ),
+                  mIsDeferred( false )
+            {}
+
+            bool isIdle() const
+            {
+                return mPendingCount == 0 && mSendQueue.empty();
+            }
+        };
+        typedef std::shared_ptr<ConnectionState> ConnectionStatePtr;
+
+        enum ActionType {
+            SEND_MESSAGE,
+            CLOSE_CONNECTION,
+            DETACH_CONNECTION,
+        };
+
+        struct Action {
+            ActionType   mType;
+            ConnectionID mID;
+            PacketData   mMessage;
+        };
+
+        Server             &mServer;
+        MessageHandler      mHandler;
+        EventLoopParameters mParameters;
+        int            mEpoll;
+        int            mWakeupEvent;
+        volatile bool  mIsContinue;
+        ConnectionID   mNextID;
+        bool           mIsAcceptPaused;
+        time_t         mAcceptResumeTime;
+
+        std::map<ConnectionID, ConnectionStatePtr> mConnections;
+        std::vector<ConnectionID>                  mDeferredConnections;
+
+        boost::mutex                          mMutex;
+        boost::condition_variable             mDetachCondition;
+        std::deque<Action>                    mActions;
+        std::map<ConnectionID, ConnectionPtr> mDetachedConnections;
+
+        void postAction( const Action &action );
+        void processActions();
+        void acceptConnections();
+        void pauseAccepting();
+        void resumeAccepting();
+        void retryDeferredConnections();
+        void readMessages( ConnectionID id, ConnectionState &state );
+        void dispatchMessages( ConnectionID id, ConnectionState &state );
+        void writeMessages( ConnectionID id, ConnectionState &state );
+        bool isReadable( const ConnectionState &state ) const;
+        void updateConnection( ConnectionID id, ConnectionState &state );
+        void removeConnection( ConnectionID id );
+        void removeInactiveConnections();
+    };
+}
+
+#endif
@@ -1,5 +1,6 @@
 #include "tcpv4server.hpp"
 #include <cstring>
+#include <fcntl.h>
 #include <sys/socket.h>
 #include <unistd.h>
 
@@ -24,6 +25,24 @@ namespace tcpv4
             shutdown( mTCPSocket, SHUT_WR );
     }
 
+    static void setSocketNonBlocking( int fd, bool is_nonblocking )
+    {
+        int flags = fcntl( fd, F_GETFL, 0 );
+        if ( flags < 0 )
+            throw SocketError( getErrorMessage( "cannot get socket flags", errno ) );
+        if ( is_nonblocking )
+            flags |= O_NONBLOCK;
+        else
+            flags &= ~O_NONBLOCK;
+        if ( fcntl( fd, F_SETFL, flags ) < 0 )
+            throw SocketError( getErrorMessage( "cannot set socket flags", errno ) );
+    }
+
+    void Connection::setNonBlocking( bool is_nonblocking )
+    {
+        setSocketNonBlocking( mTCPSocket, is_nonblocking );
+    }
+
     PacketData Connection::receive( int size )
     {
         PacketData recv_buffer;
@@ -96,7 +115,7 @@ namespace tcpv4
             throw SocketError( getErrorMessage( "cannot bind to " + parameters.mAddress, errno ) );
         }
 
-        if ( listen( mTCPSocket, 10 ) < 0 ) {
+        if ( listen( mTCPSocket, SOMAXCONN ) < 0 ) {
             close( mTCPSocket );
             mTCPSocket = -1;
             throw SocketError( getErrorMessage( "cannot listen", errno ) );
@@ -108,6 +127,11 @@ namespace tcpv4
         close( mTCPSocket );
     }
 
+    void Server::setNonBlocking( bool is_nonblocking )
+    {
+        setSocketNonBlocking( mTCPSocket, is_nonblocking );
+    }
+
     ConnectionPtr Server::acceptConnection()
     {
         sockaddr_in socket_address;
@@ -117,8 +141,10 @@ namespace tcpv4
         int new_connection =
             accept( mTCPSocket, reinterpret_cast<sockaddr *>( &socket_address ), &socket_address_size );
         if ( new_connection < 0 ) {
-            if ( errno == EAGAIN || errno == EINTR )
+            if ( errno == EINTR )
                 goto retry;
+            if ( errno == EAGAIN || errno == EWOULDBLOCK )
+                return ConnectionPtr();
             throw SocketError( getErrorMessage( "cannot accept", errno ) );
         }
         return std::make_shared<Connection>( new_connection );
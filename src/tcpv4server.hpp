@@ -24,6 +24,12 @@ namespace tcpv4
         }
         ~Connection();
 
+        int getSocket() const
+        {
+            return mTCPSocket;
+        }
+        void setNonBlocking( bool is_nonblocking );
+
         PacketData receive( int size );
 
         ssize_t send( const PacketData & );
@@ -46,6 +52,15 @@ namespace tcpv4
         Server( const ServerParameters &p );
         ~Server();
 
+        int getSocket() const
+        {
+            return mTCPSocket;
+        }
+        void setNonBlocking( bool is_nonblocking );
+
+        /*!
+         * @return NULL if no connection is pending on non-blocking socket.
+         */
         ConnectionPtr acceptConnection();
     };
 }
@@ -1,32 +1,131 @@
 #include "threadpool.hpp"
+#include <cerrno>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#include <stdexcept>
 
 namespace utils
 {
-    void ThreadPool::submit( Request req )
+    const int SPIN_COUNT = 64;
+
+    /*!
+     * count submitters in progress, so that workers do not exit before their requests are queued.
+     */
+    class SubmittingGuard : private boost::noncopyable
     {
-        boost::unique_lock<boost::mutex> lock( mMutex );
-        mRequests.push_back( req );
-        mCondition.notify_all();
+    public:
+        SubmittingGuard( std::atomic<int> &counter )
+            : mCounter( counter )
+        {
+            mCounter++;
+        }
+
+        ~SubmittingGuard()
+        {
+            mCounter--;
+        }
+
+    private:
+        std::atomic<int> &mCounter;
+    };
+
+    ThreadPool::~ThreadPool()
+    {
+        stop();
+        join();
+    }
+
+    bool ThreadPool::trySubmit( Request req )
+    {
+        SubmittingGuard guard( mSubmittingCount );
+        if ( ! mIsContinue )
+            return false;
+        if ( ! mRequests.push( req ) )
+            return false;
+
+        // wake up one idle worker only if someone sleeps.
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+        if ( mIdleWorkerCount.load( std::memory_order_relaxed ) > 0 ) {
+            boost::unique_lock<boost::mutex> lock( mMutex );
+            mWorkerCondition.notify_one();
+        }
+        return true;
     }
 
-    Request ThreadPool::pop()
+    bool ThreadPool::submit( Request req )
     {
+        for ( int i = 0; i < SPIN_COUNT; i++ ) {
+            if ( trySubmit( req ) )
+                return true;
+            if ( ! mIsContinue )
+                return false;
+            boost::this_thread::yield();
+        }
+
+        SubmittingGuard guard( mSubmittingCount );
         boost::unique_lock<boost::mutex> lock( mMutex );
-        while ( mRequests.empty() )
-            mCondition.wait( lock );
+        mWaitingProducerCount++;
+        while ( true ) {
+            if ( ! mIsContinue ) {
+                mWaitingProducerCount--;
+                return false;
+            }
+            if ( mRequests.push( req ) )
+                break;
+            mProducerCondition.wait( lock );
+        }
+        mWaitingProducerCount--;
+        if ( mIdleWorkerCount > 0 )
+            mWorkerCondition.notify_one();
+        return true;
+    }
+
+    bool ThreadPool::isFinished() const
+    {
+        return ! mIsContinue && mSubmittingCount == 0;
+    }
 
-        Request req = mRequests[0];
-        mRequests.pop_front();
+    bool ThreadPool::pop( Request &req )
+    {
+        for ( int i = 0; i < SPIN_COUNT; i++ ) {
+            if ( mRequests.pop( req ) )
+                return true;
+            if ( ! mIsContinue )
+                break;
+            boost::this_thread::yield();
+        }
 
-        mCondition.notify_all();
-        return req;
+        boost::unique_lock<boost::mutex> lock( mMutex );
+        mIdleWorkerCount++;
+        while ( true ) {
+            if ( mRequests.pop( req ) ) {
+                mIdleWorkerCount--;
+                return true;
+            }
+            // process all queued requests before exit.
+            if ( isFinished() ) {
+                mIdleWorkerCount--;
+                return false;
+            }
+            if ( mIsContinue )
+                mWorkerCondition.wait( lock );
+            else
+                mWorkerCondition.timed_wait( lock, boost::posix_time::milliseconds( 1 ) );
+        }
     }
 
     void ThreadPool::work()
     {
-        while ( mIsContinue ) {
-            Request req = pop();
+        Request req;
+        while ( pop( req ) ) {
+            std::atomic_thread_fence( std::memory_order_seq_cst );
+            if ( mWaitingProducerCount.load( std::memory_order_relaxed ) > 0 ) {
+                boost::unique_lock<boost::mutex> lock( mMutex );
+                mProducerCondition.notify_one();
+            }
             req();
+            req.clear();
         }
     }
 
@@ -38,12 +137,244 @@ namespace utils
 
     void ThreadPool::join()
     {
-        for ( auto th : mThreads )
-            th->join();
+        for ( auto th : mThreads ) {
+            if ( th->joinable() )
+                th->join();
+        }
     }
 
     void ThreadPool::stop()
     {
+        boost::unique_lock<boost::mutex> lock( mMutex );
+        mIsContinue = false;
+        mWorkerCondition.notify_all();
+        mProducerCondition.notify_all();
+    }
+
+    struct CurrentWorker {
+        const WorkStealingThreadPool *mPool;
+        unsigned int                  mIndex;
+    };
+
+    static thread_local CurrentWorker current_worker = { nullptr, 0 };
+
+    WorkStealingThreadPool::WorkStealingThreadPool( unsigned int thread_count,
+                                                    unsigned int queue_size,
+                                                    bool         enable_cpu_affinity )
+        : mIsContinue( true ), mThreadCount( thread_count > 0 ? thread_count : 1 ),
+          mQueueSize( queue_size ), mEnableCPUAffinity( enable_cpu_affinity ),
+          mNextQueue( 0 ), mStolenCount( 0 ), mRequestCount( 0 ), mIdleWorkerCount( 0 ),
+          mWaitingProducerCount( 0 ), mSubmittingCount( 0 )
+    {
+        for ( unsigned int i = 0; i < mThreadCount; i++ )
+            mQueues.push_back( std::make_shared<WorkerQueue>() );
+    }
+
+    WorkStealingThreadPool::~WorkStealingThreadPool()
+    {
+        stop();
+        join();
+    }
+
+    bool WorkStealingThreadPool::push( Request &req, bool is_wait )
+    {
+        SubmittingGuard guard( mSubmittingCount );
+
+        while ( true ) {
+            if ( ! mIsContinue )
+                return false;
+            unsigned int count = mRequestCount.load();
+            if ( count < mQueueSize ) {
+                if ( mRequestCount.compare_exchange_weak( count, count + 1 ) )
+                    break;
+                continue;
+            }
+            if ( ! is_wait )
+                return false;
+
+            boost::unique_lock<boost::mutex> lock( mMutex );
+            mWaitingProducerCount++;
+            if ( mIsContinue && mRequestCount >= mQueueSize )
+                mProducerCondition.wait( lock );
+            mWaitingProducerCount--;
+        }
+
+        if ( current_worker.mPool == this ) {
+            WorkerQueue &queue = *mQueues[ current_worker.mIndex ];
+            boost::unique_lock<boost::mutex> lock( queue.mMutex );
+            queue.mRequests.push_back( req );
+        }
+        else {
+            // requests from outside the pool are spread over the workers and processed in FIFO order.
+            WorkerQueue &queue = *mQueues[ mNextQueue++ % mThreadCount ];
+            boost::unique_lock<boost::mutex> lock( queue.mMutex );
+            queue.mInjected.push_back( req );
+        }
+
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+        if ( mIdleWorkerCount.load( std::memory_order_relaxed ) > 0 ) {
+            boost::unique_lock<boost::mutex> lock( mMutex );
+            mWorkerCondition.notify_one();
+        }
+        return true;
+    }
+
+    bool WorkStealingThreadPool::submit( Request req )
+    {
+        return push( req, true );
+    }
+
+    bool WorkStealingThreadPool::trySubmit( Request req )
+    {
+        return push( req, false );
+    }
+
+    bool WorkStealingThreadPool::popOwn( unsigned int index, Request &req )
+    {
+        WorkerQueue &queue = *mQueues[ index ];
+        boost::unique_lock<boost::mutex> lock( queue.mMutex );
+        if ( ! queue.mRequests.empty() ) {
+            req = queue.mRequests.back();
+            queue.mRequests.pop_back();
+            return true;
+        }
+        if ( ! queue.mInjected.empty() ) {
+            req = queue.mInjected.front();
+            queue.mInjected.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    bool WorkStealingThreadPool::steal( unsigned int index, Request &req, bool is_wait )
+    {
+        for ( unsigned int i = 1; i < mThreadCount; i++ ) {
+            WorkerQueue &victim = *mQueues[ ( index + i ) % mThreadCount ];
+            boost::unique_lock<boost::mutex> lock( victim.mMutex, boost::defer_lock );
+            if ( is_wait )
+                lock.lock();
+            else if ( ! lock.try_lock() )
+                continue;
+            std::deque<Request> &requests = victim.mInjected.empty() ? victim.mRequests : victim.mInjected;
+            if ( requests.empty() )
+                continue;
+            req = requests.front();
+            requests.pop_front();
+            mStolenCount.fetch_add( 1, std::memory_order_relaxed );
+            return true;
+        }
+        return false;
+    }
+
+    bool WorkStealingThreadPool::isFinished() const
+    {
+        return ! mIsContinue && mSubmittingCount == 0 && mRequestCount == 0;
+    }
+
+    bool WorkStealingThreadPool::pop( unsigned int index, Request &req )
+    {
+        for ( int i = 0; i < SPIN_COUNT; i++ ) {
+            if ( popOwn( index, req ) )
+                return true;
+            if ( steal( index, req, false ) )
+                return true;
+            if ( isFinished() )
+                return false;
+            boost::this_thread::yield();
+        }
+
+        // check all queues without skipping locked ones before sleeping.
+        // producers notify only after this worker is counted as idle, so no request is missed.
+        boost::unique_lock<boost::mutex> lock( mMutex );
+        mIdleWorkerCount++;
+        while ( true ) {
+            if ( popOwn( index, req ) || steal( index, req, true ) ) {
+                mIdleWorkerCount--;
+                return true;
+            }
+            if ( isFinished() ) {
+                mIdleWorkerCount--;
+                return false;
+            }
+            if ( mIsContinue )
+                mWorkerCondition.wait( lock );
+            else
+                mWorkerCondition.timed_wait( lock, boost::posix_time::milliseconds( 1 ) );
+        }
+    }
+
+    void WorkStealingThreadPool::notifyProducer()
+    {
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+        if ( mWaitingProducerCount.load( std::memory_order_relaxed ) > 0 ) {
+            boost::unique_lock<boost::mutex> lock( mMutex );
+            mProducerCondition.notify_one();
+        }
+    }
+
+    void WorkStealingThreadPool::work( unsigned int index )
+    {
+        current_worker.mPool  = this;
+        current_worker.mIndex = index;
+
+        Request req;
+        while ( pop( index, req ) ) {
+            mRequestCount--;
+            notifyProducer();
+            req();
+            req.clear();
+        }
+    }
+
+    // pin the worker to the index-th CPU among the CPUs allowed for the process( cpuset ).
+    void WorkStealingThreadPool::setCPUAffinity( boost::thread &thread, unsigned int index, const cpu_set_t &allowed_cpus )
+    {
+        int cpu_count = CPU_COUNT( &allowed_cpus );
+        if ( cpu_count == 0 )
+            return;
+
+        int nth = index % cpu_count;
+        int cpu = 0;
+        for ( ; cpu < CPU_SETSIZE ; cpu++ ) {
+            if ( CPU_ISSET( cpu, &allowed_cpus ) && nth-- == 0 )
+                break;
+        }
+
+        cpu_set_t cpu_set;
+        CPU_ZERO( &cpu_set );
+        CPU_SET( cpu, &cpu_set );
+        int error = pthread_setaffinity_np( thread.native_handle(), sizeof( cpu_set ), &cpu_set );
+        if ( error != 0 )
+            throw std::runtime_error( std::string( "cannot set CPU affinity: " ) + std::strerror( error ) );
+    }
+
+    void WorkStealingThreadPool::start()
+    {
+        cpu_set_t allowed_cpus;
+        CPU_ZERO( &allowed_cpus );
+        if ( mEnableCPUAffinity && sched_getaffinity( 0, sizeof( allowed_cpus ), &allowed_cpus ) != 0 )
+            throw std::runtime_error( std::string( "cannot get CPU affinity: " ) + std::strerror( errno ) );
+
+        for ( unsigned int i = 0 ; i < mThreadCount ; i++ ) {
+            mThreads.push_back( std::make_shared<boost::thread>( &WorkStealingThreadPool::work, this, i ) );
+            if ( mEnableCPUAffinity )
+                setCPUAffinity( *mThreads.back(), i, allowed_cpus );
+        }
+    }
+
+    void WorkStealingThreadPool::join()
+    {
+        for ( auto th : mThreads ) {
+            if ( th->joinable() )
+                th->join();
+        }
+    }
+
+    void WorkStealingThreadPool::stop()
+    {
+        boost::unique_lock<boost::mutex> lock( mMutex );
         mIsContinue = false;
+        mWorkerCondition.notify_all();
+        mProducerCondition.notify_all();
     }
 }
@@ -1,40 +1,148 @@
 #ifndef THREAD_POOL_HPP
 #define THREAD_POOL_HPP
 
+#include "mpmcqueue.hpp"
 #include <boost/noncopyable.hpp>
 #include <boost/thread.hpp>
 #include <boost/function.hpp>
+#include <atomic>
+#include <sched.h>
 #include <deque>
+#include <memory>
+#include <vector>
 
 namespace utils
 {
     typedef boost::function<void ()> Request;
 
-    class ThreadPool : private boost::noncopyable
+    const unsigned int DEFAULT_THREAD_POOL_QUEUE_SIZE = 4096;
+
+    class AbstractThreadPool : private boost::noncopyable
     {
     public:
-        ThreadPool( unsigned int thread_count )
-            : mIsContinue( true ), mThreadCount( thread_count )
+        virtual ~AbstractThreadPool() {}
+
+        /*!
+         * wait until the queue has space if it is full.
+         * @return false if the pool is already stopped.
+         */
+        virtual bool submit( Request req ) = 0;
+
+        /*!
+         * @return false if the queue is full or the pool is already stopped.
+         */
+        virtual bool trySubmit( Request req ) = 0;
+
+        virtual void start() = 0;
+
+        /*!
+         * wait for workers which exit after stop() and processing all queued requests.
+         */
+        virtual void join() = 0;
+
+        /*!
+         * stop accepting requests and wake up idle workers.
+         */
+        virtual void stop() = 0;
+    };
+
+    typedef std::shared_ptr<AbstractThreadPool> ThreadPoolPtr;
+
+    class ThreadPool : public AbstractThreadPool
+    {
+    public:
+        ThreadPool( unsigned int thread_count, unsigned int queue_size = DEFAULT_THREAD_POOL_QUEUE_SIZE )
+            : mIsContinue( true ), mThreadCount( thread_count ), mRequests( queue_size ),
+              mIdleWorkerCount( 0 ), mWaitingProducerCount( 0 ), mSubmittingCount( 0 )
         {}
 
-        void submit( Request req );
-        void start();
-        void join();
-        void stop();
+        virtual ~ThreadPool();
+
+        virtual bool submit( Request req );
+        virtual bool trySubmit( Request req );
+        virtual void start();
+        virtual void join();
+        virtual void stop();
         void work();
 
     private:
-        volatile bool mIsContinue;
-        unsigned int  mThreadCount;
-        std::deque<Request> mRequests;
+        std::atomic<bool>   mIsContinue;
+        unsigned int        mThreadCount;
+        MPMCQueue<Request>  mRequests;
+        std::atomic<int>    mIdleWorkerCount;
+        std::atomic<int>    mWaitingProducerCount;
+        std::atomic<int>    mSubmittingCount;
 
         std::vector<std::shared_ptr<boost::thread>> mThreads;
         boost::mutex mMutex;
-        boost::condition_variable mCondition;
+        boost::condition_variable mWorkerCondition;
+        boost::condition_variable mProducerCondition;
 
-        Request pop();
+        bool pop( Request &req );
+        bool isFinished() const;
+    };
+
+    /*!
+     * thread pool which has deques for each worker.
+     * requests submitted by a worker are pushed into the local deque of the worker, and the worker takes
+     * the newest one first. requests submitted from outside the pool are distributed to the injected
+     * deques of the workers in round robin, and each of them is processed in FIFO order, so that old
+     * queries are not starved by new ones.
+     * a worker whose deques are empty steals the oldest request from other workers, so that
+     * expensive requests do not leave cores idle.
+     */
+    class WorkStealingThreadPool : public AbstractThreadPool
+    {
+    public:
+        WorkStealingThreadPool( unsigned int thread_count,
+                                unsigned int queue_size = DEFAULT_THREAD_POOL_QUEUE_SIZE,
+                                bool         enable_cpu_affinity = false );
+        virtual ~WorkStealingThreadPool();
+
+        virtual bool submit( Request req );
+        virtual bool trySubmit( Request req );
+        virtual void start();
+        virtual void join();
+        virtual void stop();
+        void work( unsigned int index );
+
+        /*!
+         * @return count of requests taken from the deques of other workers.
+         */
+        uint64_t getStolenCount() const { return mStolenCount; }
+
+    private:
+        struct WorkerQueue {
+            boost::mutex        mMutex;
+            std::deque<Request> mRequests;  // submitted by the worker
+            std::deque<Request> mInjected;  // submitted from outside the pool
+        };
+
+        std::atomic<bool>         mIsContinue;
+        unsigned int              mThreadCount;
+        unsigned int              mQueueSize;
+        bool                      mEnableCPUAffinity;
+        std::vector<std::shared_ptr<WorkerQueue>> mQueues;
+        std::atomic<unsigned int> mNextQueue;     // injected deque for the next request from outside the pool
+        std::atomic<uint64_t>     mStolenCount;
+        std::atomic<unsigned int> mRequestCount;
+        std::atomic<int>          mIdleWorkerCount;
+        std::atomic<int>          mWaitingProducerCount;
+        std::atomic<int>          mSubmittingCount;
+
+        std::vector<std::shared_ptr<boost::thread>> mThreads;
+        boost::mutex              mMutex;
+        boost::condition_variable mWorkerCondition;
+        boost::condition_variable mProducerCondition;
+
+        bool push( Request &req, bool is_wait );
+        bool popOwn( unsigned int index, Request &req );
+        bool steal( unsigned int index, Request &req, bool is_wait );
+        bool pop( unsigned int index, Request &req );
+        bool isFinished() const;
+        void notifyProducer();
+        void setCPUAffinity( boost::thread &thread, unsigned int index, const cpu_set_t &allowed_cpus );
     };
 }
 
 #endif
-
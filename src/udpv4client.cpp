@@ -16,6 +16,52 @@ namespace udpv4
 
     const uint16_t UDP_RECEIVE_BUFFER_SIZE = 65535;
 
+    std::string getAddressString( const sockaddr_storage &address )
+    {
+        if ( address.ss_family != AF_INET )
+            return "";
+        return convertAddressBinaryToString( reinterpret_cast<const sockaddr_in *>( &address )->sin_addr );
+    }
+
+    uint16_t getPort( const sockaddr_storage &address )
+    {
+        if ( address.ss_family != AF_INET )
+            return 0;
+        return ntohs( reinterpret_cast<const sockaddr_in *>( &address )->sin_port );
+    }
+
+    socklen_t setSocketAddress( const std::string &address, uint16_t port, sockaddr_storage &socket_address )
+    {
+        sockaddr_in *socket_address_v4 = reinterpret_cast<sockaddr_in *>( &socket_address );
+        std::memset( socket_address_v4, 0, sizeof( sockaddr_in ) );
+        socket_address_v4->sin_family = AF_INET;
+        socket_address_v4->sin_addr   = convertAddressStringToBinary( address );
+        socket_address_v4->sin_port   = htons( port );
+        return sizeof( sockaddr_in );
+    }
+
+    std::string ClientParameters::getAddress() const
+    {
+        if ( mSocketAddressLength == 0 )
+            return mAddress;
+        return getAddressString( mSocketAddress );
+    }
+
+    uint16_t ClientParameters::getPort() const
+    {
+        if ( mSocketAddressLength == 0 )
+            return mPort;
+        return udpv4::getPort( mSocketAddress );
+    }
+
+    socklen_t ClientParameters::getSocketAddress( sockaddr_storage &socket_address ) const
+    {
+        if ( mSocketAddressLength == 0 )
+            return setSocketAddress( mAddress, mPort, socket_address );
+        std::memcpy( &socket_address, &mSocketAddress, mSocketAddressLength );
+        return mSocketAddressLength;
+    }
+
     Client::~Client()
     {
         closeSocket();
@@ -90,29 +136,25 @@ namespace udpv4
         if ( is_nonblocking )
             flags |= MSG_DONTWAIT;
 
-        sockaddr_in peer_address;
-        socklen_t   peer_address_size = sizeof( peer_address );
+        PacketInfo  info;
+        socklen_t   peer_address_size = sizeof( info.mSource );
         PacketData  receive_buffer( UDP_RECEIVE_BUFFER_SIZE );
         int         recv_size = recvfrom( mUDPSocket,
                                           receive_buffer.data(),
                                           UDP_RECEIVE_BUFFER_SIZE,
                                           flags,
-                                          reinterpret_cast<sockaddr *>( &peer_address ),
+                                          reinterpret_cast<sockaddr *>( &info.mSource ),
                                           &peer_address_size );
         if ( recv_size < 0 ) {
             int error_num = errno;
             if ( error_num == EAGAIN ) {
-                PacketInfo info;
-                return info;
+                return PacketInfo();
             }
             std::perror( "cannot recv" );
             throw SocketError( getErrorMessage( "cannot recv packet", error_num ) );
         }
 
-        PacketInfo info;
-        info.mSourceAddress = convertAddressBinaryToString( peer_address.sin_addr );
-        info.mSourcePort    = ntohs( peer_address.sin_port );
-        info.mPayload       = receive_buffer;
+        info.mPayload = receive_buffer;
         return info;
     }
 
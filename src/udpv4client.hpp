@@ -3,24 +3,80 @@
 
 #include "wireformat.hpp"
 #include <boost/cstdint.hpp>
+#include <netinet/in.h>
 #include <string>
+#include <sys/socket.h>
 #include <vector>
 
 namespace udpv4
 {
 
+    /*!
+     * @return text form of the IPv4 address in sockaddr
+     */
+    std::string getAddressString( const sockaddr_storage &address );
+    uint16_t    getPort( const sockaddr_storage &address );
+    socklen_t   setSocketAddress( const std::string &address, uint16_t port, sockaddr_storage &socket_address );
+
     struct ClientParameters {
-        std::string mAddress;
-        uint16_t    mPort;
+        std::string      mAddress;
+        uint16_t         mPort;
+        sockaddr_storage mSocketAddress;
+        socklen_t        mSocketAddressLength;
+
+        ClientParameters()
+            : mPort( 0 ), mSocketAddressLength( 0 )
+        {}
+
+        /*!
+         * destination given by binary address.
+         * mAddress and mPort are not set, use getAddress() and getPort() for them.
+         */
+        ClientParameters( const sockaddr_storage &address, socklen_t length )
+            : mPort( 0 ), mSocketAddress( address ), mSocketAddressLength( length )
+        {}
+
+        std::string getAddress() const;
+        uint16_t    getPort() const;
+
+        /*!
+         * convert mAddress and mPort into socket_address unless binary address is given.
+         * @return length of socket_address
+         */
+        socklen_t getSocketAddress( sockaddr_storage &socket_address ) const;
     };
 
     struct PacketInfo {
-        std::string          mSourceAddress;
-        std::string          mDestinationAddress;
-        uint16_t             mSourcePort;
-        uint16_t             mDestinationPort;
+        sockaddr_storage     mSource;
+        sockaddr_storage     mDestination;
         std::vector<uint8_t> mPayload;
 
+        PacketInfo()
+        {
+            mSource.ss_family      = AF_UNSPEC;
+            mDestination.ss_family = AF_UNSPEC;
+        }
+
+        std::string getSourceAddress() const
+        {
+            return getAddressString( mSource );
+        }
+
+        uint16_t getSourcePort() const
+        {
+            return getPort( mSource );
+        }
+
+        std::string getDestinationAddress() const
+        {
+            return getAddressString( mDestination );
+        }
+
+        uint16_t getDestinationPort() const
+        {
+            return getPort( mDestination );
+        }
+
         /*!
          * @return payload length of UDP packet(bytes)
          */
@@ -16,8 +16,6 @@
 namespace udpv4
 {
 
-    const uint16_t UDP_RECEIVE_BUFFER_SIZE = 65535;
-
     Server::~Server()
     {
         closeSocket();
@@ -51,6 +49,13 @@ namespace udpv4
             std::string msg = getErrorMessage( "cannot setsocketopt SO_REUSEADDR", errno );
             throw SocketError( msg );
         }
+        if ( mParameters.mReusePort ) {
+            err = setsockopt( mUDPSocket, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one) );
+            if ( err ) {
+                std::string msg = getErrorMessage( "cannot setsocketopt SO_REUSEPORT", errno );
+                throw SocketError( msg );
+            }
+        }
 
         sockaddr_in socket_address;
         std::memset( &socket_address, 0, sizeof( socket_address ) );
@@ -96,20 +101,17 @@ namespace udpv4
         if ( ! isEnableSocket() )
             openSocket();
 
-        sockaddr_in socket_address;
-        std::memset( &socket_address, 0, sizeof( socket_address ) );
-        socket_address.sin_family = AF_INET;
-        socket_address.sin_addr   = convertAddressStringToBinary( dest.mAddress );
-        socket_address.sin_port   = htons( dest.mPort );
-        int sent_size             = sendto( mUDPSocket,
-                                            data,
-                                            size,
-                                            0,
-                                            reinterpret_cast<const sockaddr *>( &socket_address ),
-                                            sizeof( socket_address ) );
+        sockaddr_storage socket_address;
+        socklen_t        socket_address_length = dest.getSocketAddress( socket_address );
+        int              sent_size             = sendto( mUDPSocket,
+                                                         data,
+                                                         size,
+                                                         0,
+                                                         reinterpret_cast<const sockaddr *>( &socket_address ),
+                                                         socket_address_length );
         if ( sent_size < 0 ) {
             std::ostringstream s;
-            s << "cannot send to " << dest.mAddress << ":" << dest.mPort << ".";
+            s << "cannot send to " << dest.getAddress() << ":" << dest.getPort() << ".";
             std::string msg = getErrorMessage( s.str(), errno );
             throw SocketError( msg );
         }
@@ -121,12 +123,229 @@ namespace udpv4
         if ( ! isEnableSocket() )
             openSocket();
 
-        sockaddr_in socket_address;
-        std::memset( &socket_address, 0, sizeof( socket_address ) );
-        socket_address.sin_family = AF_INET;
-        socket_address.sin_addr   = convertAddressStringToBinary( dest.mAddress );
-        socket_address.sin_port   = htons( dest.mPort );
-        return data.send( mUDPSocket, reinterpret_cast<const sockaddr *>( &socket_address ), sizeof( socket_address ) );
+        sockaddr_storage socket_address;
+        socklen_t        socket_address_length = dest.getSocketAddress( socket_address );
+        return data.send( mUDPSocket, reinterpret_cast<const sockaddr *>( &socket_address ), socket_address_length );
+    }
+
+    unsigned int Server::sendPackets( const std::vector<OutgoingPacket> &packets )
+    {
+        if ( ! isEnableSocket() )
+            openSocket();
+
+        boost::scoped_array<sockaddr_storage>          socket_addresses( new sockaddr_storage[ packets.size() ] );
+        boost::scoped_array<WireFormat::MessageHeader> headers( new WireFormat::MessageHeader[ packets.size() ] );
+        boost::scoped_array<mmsghdr>                   messages( new mmsghdr[ packets.size() ] );
+
+        unsigned int message_count = 0;
+        for ( auto &packet : packets ) {
+            if ( packet.mPayload.size() == 0 )
+                continue;
+
+            sockaddr_storage &socket_address        = socket_addresses[ message_count ];
+            socklen_t         socket_address_length = packet.mDestination.getSocketAddress( socket_address );
+
+            WireFormat::MessageHeader &header = headers[ message_count ];
+            header.setDestination( reinterpret_cast<const sockaddr *>( &socket_address ), socket_address_length );
+            header.setBuffers( packet.mPayload );
+
+            std::memset( &messages[ message_count ], 0, sizeof( mmsghdr ) );
+            messages[ message_count ].msg_hdr = header.header;
+            message_count++;
+        }
+
+        unsigned int sent_count   = 0;
+        unsigned int failed_count = 0;
+        int          error_num    = 0;
+        for ( unsigned int i = 0; i < message_count; ) {
+            int sent = sendmmsg( mUDPSocket, &messages[ i ], message_count - i, 0 );
+            if ( sent < 0 ) {
+                if ( errno == EINTR )
+                    continue;
+                // skip the packet which cannot be sent, and send the rest of packets.
+                error_num = errno;
+                failed_count++;
+                i++;
+                continue;
+            }
+            sent_count += sent;
+            i          += sent;
+        }
+
+        if ( sent_count == 0 && failed_count > 0 ) {
+            std::string msg = getErrorMessage( "cannot sendmmsg", error_num );
+            throw SocketError( msg );
+        }
+        return sent_count;
+    }
+
+    static const in_pktinfo *findPacketInfo( msghdr &msg )
+    {
+        for ( cmsghdr *cmsg = CMSG_FIRSTHDR( &msg ); cmsg != NULL; cmsg = CMSG_NXTHDR( &msg, cmsg ) ) {
+            if ( cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_PKTINFO ) {
+                return reinterpret_cast<const in_pktinfo *>( CMSG_DATA( cmsg ) );
+            }
+        }
+        return NULL;
+    }
+
+    const int CONTROL_BUFFER_SIZE = 512;
+
+    static void setDestination( const in_pktinfo &pktinfo, uint16_t port, sockaddr_storage &destination )
+    {
+        sockaddr_in *destination_v4 = reinterpret_cast<sockaddr_in *>( &destination );
+        std::memset( destination_v4, 0, sizeof( sockaddr_in ) );
+        destination_v4->sin_family = AF_INET;
+        destination_v4->sin_addr   = pktinfo.ipi_addr;
+        destination_v4->sin_port   = htons( port );
+    }
+
+    std::string PacketView::getDestinationAddress() const
+    {
+        return convertAddressBinaryToString( mPacketInfo.ipi_addr );
+    }
+
+    ReceiveBuffer::ReceiveBuffer( unsigned int slot_count, uint16_t slot_size )
+        : mSlotSize( slot_size ), mReceivedCount( 0 )
+    {
+        if ( slot_count == 0 )
+            slot_count = 1;
+
+        mBuffer.reset( new uint8_t[ slot_count * slot_size ] );
+        mControlBuffer.resize( slot_count * CONTROL_BUFFER_SIZE );
+        mMessages.resize( slot_count );
+        mIOVectors.resize( slot_count );
+        mPackets.resize( slot_count );
+
+        std::memset( mMessages.data(), 0, sizeof( mmsghdr ) * slot_count );
+        for ( unsigned int i = 0; i < slot_count; i++ ) {
+            mIOVectors[ i ].iov_base = &mBuffer[ i * slot_size ];
+            mIOVectors[ i ].iov_len  = slot_size;
+            mPackets[ i ].mData      = &mBuffer[ i * slot_size ];
+            mPackets[ i ].mLength    = 0;
+
+            msghdr &msg     = mMessages[ i ].msg_hdr;
+            msg.msg_name    = &mPackets[ i ].mSource;
+            msg.msg_iov     = &mIOVectors[ i ];
+            msg.msg_iovlen  = 1;
+            msg.msg_control = &mControlBuffer[ i * CONTROL_BUFFER_SIZE ];
+        }
+        resetMessageHeaders();
+    }
+
+    void ReceiveBuffer::resetMessageHeaders()
+    {
+        // recvmmsg(2) overwrites the length of the address and the control data.
+        for ( auto &message : mMessages ) {
+            message.msg_hdr.msg_namelen    = sizeof( sockaddr_storage );
+            message.msg_hdr.msg_controllen = CONTROL_BUFFER_SIZE;
+            message.msg_hdr.msg_flags      = 0;
+            message.msg_len                = 0;
+        }
+        mReceivedCount = 0;
+    }
+
+    ReceiveBufferPool::ReceiveBufferPool( unsigned int buffer_count, unsigned int slot_count, uint16_t slot_size )
+    {
+        for ( unsigned int i = 0; i < buffer_count; i++ ) {
+            mBuffers.push_back( std::make_shared<ReceiveBuffer>( slot_count, slot_size ) );
+            mFreeBuffers.push_back( mBuffers.back().get() );
+        }
+    }
+
+    ReceiveBuffer *ReceiveBufferPool::acquire()
+    {
+        boost::mutex::scoped_lock lock( mMutex );
+        while ( mFreeBuffers.empty() )
+            mCondition.wait( lock );
+
+        ReceiveBuffer *buffer = mFreeBuffers.back();
+        mFreeBuffers.pop_back();
+        return buffer;
+    }
+
+    ReceiveBuffer *ReceiveBufferPool::tryAcquire()
+    {
+        boost::mutex::scoped_lock lock( mMutex );
+        if ( mFreeBuffers.empty() )
+            return NULL;
+
+        ReceiveBuffer *buffer = mFreeBuffers.back();
+        mFreeBuffers.pop_back();
+        return buffer;
+    }
+
+    void ReceiveBufferPool::release( ReceiveBuffer *buffer )
+    {
+        {
+            boost::mutex::scoped_lock lock( mMutex );
+            mFreeBuffers.push_back( buffer );
+        }
+        mCondition.notify_one();
+    }
+
+    unsigned int Server::receivePackets( ReceiveBuffer &buffer, bool is_nonblocking )
+    {
+        if ( ! isEnableSocket() )
+            openSocket();
+
+        int flags = MSG_WAITFORONE;
+        if ( is_nonblocking )
+            flags |= MSG_DONTWAIT;
+
+        buffer.resetMessageHeaders();
+    retry:
+        int recv_count = recvmmsg( mUDPSocket, buffer.mMessages.data(), buffer.getSlotCount(), flags, NULL );
+        if ( recv_count < 0 ) {
+            if ( errno == EINTR )
+                goto retry;
+            if ( errno == EAGAIN || errno == EWOULDBLOCK )
+                return 0;
+            std::string msg = getErrorMessage( "cannot recvmmsg", errno );
+            throw SocketError( msg );
+        }
+
+        // packets longer than the slot( MSG_TRUNC ) or without IP_PKTINFO are dropped,
+        // and the rest are packed to the front of mPackets.
+        unsigned int packet_count = 0;
+        for ( int i = 0; i < recv_count; i++ ) {
+            msghdr           &msg     = buffer.mMessages[ i ].msg_hdr;
+            const in_pktinfo *pktinfo = findPacketInfo( msg );
+            if ( ( msg.msg_flags & MSG_TRUNC ) || pktinfo == NULL )
+                continue;
+
+            PacketView &packet      = buffer.mPackets[ packet_count ];
+            packet.mData            = static_cast<const uint8_t *>( buffer.mIOVectors[ i ].iov_base );
+            packet.mLength          = buffer.mMessages[ i ].msg_len;
+            packet.mSource          = buffer.mPackets[ i ].mSource;
+            packet.mSourceLength    = msg.msg_namelen;
+            packet.mPacketInfo      = *pktinfo;
+            packet.mDestinationPort = mParameters.mPort;
+            packet_count++;
+        }
+        buffer.mReceivedCount = packet_count;
+
+        return packet_count;
+    }
+
+    std::vector<PacketInfo> Server::receivePackets( unsigned int max_count, bool is_nonblocking )
+    {
+        if ( max_count == 0 )
+            max_count = 1;
+        if ( ! mBatchReceiveBuffer || mBatchReceiveBuffer->getSlotCount() < max_count )
+            mBatchReceiveBuffer = std::make_shared<ReceiveBuffer>( max_count );
+
+        unsigned int            recv_count = receivePackets( *mBatchReceiveBuffer, is_nonblocking );
+        std::vector<PacketInfo> packets( recv_count );
+        for ( unsigned int i = 0; i < recv_count; i++ ) {
+            const PacketView &packet = ( *mBatchReceiveBuffer )[ i ];
+            PacketInfo       &info   = packets[ i ];
+            info.mSource = packet.mSource;
+            setDestination( packet.mPacketInfo, packet.mDestinationPort, info.mDestination );
+            info.mPayload.assign( packet.begin(), packet.end() );
+        }
+
+        return packets;
     }
 
     const int RECEIVE_BUFFER_SIZE = 0xffff;
@@ -140,48 +359,53 @@ namespace udpv4
         if ( is_nonblocking )
             flags |= MSG_DONTWAIT;
 
-        std::vector<uint8_t> receive_buffer;
-        receive_buffer.resize( UDP_RECEIVE_BUFFER_SIZE );
+        // reuse the receive buffer of each thread instead of allocating 64KiB per packet.
+        static boost::thread_specific_ptr<PacketData> tls_receive_buffer;
+        if ( tls_receive_buffer.get() == NULL )
+            tls_receive_buffer.reset( new PacketData( UDP_RECEIVE_BUFFER_SIZE ) );
+        PacketData &receive_buffer = *tls_receive_buffer;
         struct msghdr      msg;
         struct iovec       iov[ 1 ];
         struct cmsghdr *   cmsg;
         uint8_t            cbuf[ 512 ];
         struct in_pktinfo *pktinfo;
-        struct sockaddr_in sin;
+        PacketInfo         info;
 
         iov[ 0 ].iov_base = &receive_buffer[ 0 ];
         iov[ 0 ].iov_len  = receive_buffer.size();
 
         std::memset( &msg, 0, sizeof( msg ) );
-        msg.msg_name       = &sin;
-        msg.msg_namelen    = sizeof( sin );
+        msg.msg_name       = &info.mSource;
+        msg.msg_namelen    = sizeof( info.mSource );
         msg.msg_iov        = iov;
         msg.msg_iovlen     = 1;
         msg.msg_control    = cbuf;
         msg.msg_controllen = sizeof( cbuf );
 
-        int recv_size = recvmsg( mUDPSocket, &msg, 0 );
-        if ( recv_size < 0 ) {
-            std::string msg = getErrorMessage( "cannot recvmsg", errno );
-            throw SocketError( msg );
-        }
+        int recv_size;
+        while ( true ) {
+            msg.msg_namelen    = sizeof( info.mSource );
+            msg.msg_controllen = sizeof( cbuf );
+            recv_size = recvmsg( mUDPSocket, &msg, 0 );
+            if ( recv_size < 0 ) {
+                std::string msg = getErrorMessage( "cannot recvmsg", errno );
+                throw SocketError( msg );
+            }
 
-        pktinfo = NULL;
-        for ( cmsg = CMSG_FIRSTHDR( &msg ); cmsg != NULL; cmsg = CMSG_NXTHDR( &msg, cmsg ) ) {
-            if ( cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_PKTINFO ) {
-                pktinfo = (struct in_pktinfo *)CMSG_DATA( cmsg );
-                break;
+            pktinfo = NULL;
+            for ( cmsg = CMSG_FIRSTHDR( &msg ); cmsg != NULL; cmsg = CMSG_NXTHDR( &msg, cmsg ) ) {
+                if ( cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_PKTINFO ) {
+                    pktinfo = (struct in_pktinfo *)CMSG_DATA( cmsg );
+                    break;
+                }
             }
-        }
 
-        if ( pktinfo == NULL ) {
-            throw SocketError( "cannot found pkginfo" );
+            // drop only the truncated packet or the packet without IP_PKTINFO, and receive the next one.
+            if ( pktinfo != NULL && ! ( msg.msg_flags & MSG_TRUNC ) )
+                break;
         }
 
-        PacketInfo info;
-        info.mSourceAddress      = convertAddressBinaryToString( sin.sin_addr );
-        info.mSourcePort         = ntohs( sin.sin_port );
-        info.mDestinationAddress = convertAddressBinaryToString( pktinfo->ipi_addr );
+        setDestination( *pktinfo, mParameters.mPort, info.mDestination );
         info.mPayload.insert( info.mPayload.end(), receive_buffer.begin(), receive_buffer.begin() + recv_size );
 
         return info;
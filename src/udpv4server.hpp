@@ -4,7 +4,12 @@
 #include "udpv4client.hpp"
 #include "wireformat.hpp"
 #include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread.hpp>
+#include <memory>
+#include <netinet/in.h>
 #include <string>
+#include <sys/socket.h>
 #include <vector>
 
 namespace udpv4
@@ -14,17 +19,149 @@ namespace udpv4
         std::string mAddress;
         uint16_t    mPort;
 	bool        mMulticast;
+	bool        mReusePort;
 
 	ServerParameters()
-	    : mPort( 0 ), mMulticast( false )
+	    : mPort( 0 ), mMulticast( false ), mReusePort( false )
 	{}
     };
 
+    /*!
+     * UDP packet sent by Server::sendPackets
+     */
+    struct OutgoingPacket {
+        ClientParameters mDestination;
+        WireFormat       mPayload;
+    };
+
+    const unsigned int DEFAULT_BATCH_SIZE      = 32;
+    const uint16_t     UDP_RECEIVE_BUFFER_SIZE = 65535;
+    const uint16_t     DNS_QUERY_BUFFER_SIZE   = 4096;  // EDNS0 receive limit. larger queries are truncated
+
+    /*!
+     * received UDP packet which refers to a slot of ReceiveBuffer.
+     * valid until the ReceiveBuffer is passed to Server::receivePackets again.
+     */
+    struct PacketView {
+        const uint8_t   *mData;
+        uint16_t         mLength;
+        sockaddr_storage mSource;
+        socklen_t        mSourceLength;
+        in_pktinfo       mPacketInfo;
+        uint16_t         mDestinationPort;
+
+        uint16_t getPayloadLength() const
+        {
+            return mLength;
+        }
+
+        const uint8_t *getData() const
+        {
+            return mData;
+        }
+
+        const uint8_t *begin() const
+        {
+            return mData;
+        }
+
+        const uint8_t *end() const
+        {
+            return mData + mLength;
+        }
+
+        std::string getSourceAddress() const
+        {
+            return getAddressString( mSource );
+        }
+
+        uint16_t getSourcePort() const
+        {
+            return getPort( mSource );
+        }
+
+        std::string getDestinationAddress() const;
+    };
+
+    /*!
+     * receive buffers and message headers for recvmmsg(2), allocated once and reused.
+     * Slots are not initialized, so that pages are committed only when packets are received into them.
+     */
+    class ReceiveBuffer : private boost::noncopyable
+    {
+    public:
+        ReceiveBuffer( unsigned int slot_count = DEFAULT_BATCH_SIZE, uint16_t slot_size = UDP_RECEIVE_BUFFER_SIZE );
+
+        unsigned int getSlotCount() const
+        {
+            return mPackets.size();
+        }
+
+        /*!
+         * @return count of packets received by the last Server::receivePackets call
+         */
+        unsigned int size() const
+        {
+            return mReceivedCount;
+        }
+
+        bool empty() const
+        {
+            return mReceivedCount == 0;
+        }
+
+        const PacketView &operator[]( unsigned int index ) const
+        {
+            return mPackets[ index ];
+        }
+
+    private:
+        friend class Server;
+
+        uint16_t                   mSlotSize;
+        unsigned int               mReceivedCount;
+        std::unique_ptr<uint8_t[]> mBuffer;
+        std::vector<uint8_t>       mControlBuffer;
+        std::vector<mmsghdr>       mMessages;
+        std::vector<iovec>         mIOVectors;
+        std::vector<PacketView>    mPackets;
+
+        void resetMessageHeaders();
+    };
+
+    /*!
+     * free list of ReceiveBuffer, used when received packets are handed to other threads.
+     */
+    class ReceiveBufferPool : private boost::noncopyable
+    {
+    public:
+        ReceiveBufferPool( unsigned int buffer_count, unsigned int slot_count = DEFAULT_BATCH_SIZE,
+                           uint16_t slot_size = UDP_RECEIVE_BUFFER_SIZE );
+
+        /*!
+         * get unused buffer. block until another thread releases a buffer if all buffers are used.
+         */
+        ReceiveBuffer *acquire();
+
+        /*!
+         * @return NULL if all buffers are used.
+         */
+        ReceiveBuffer *tryAcquire();
+        void release( ReceiveBuffer *buffer );
+
+    private:
+        std::vector<std::shared_ptr<ReceiveBuffer>> mBuffers;
+        std::vector<ReceiveBuffer *>                mFreeBuffers;
+        boost::mutex                                mMutex;
+        boost::condition_variable                   mCondition;
+    };
+
     class Server
     {
     private:
         ServerParameters mParameters;
         int              mUDPSocket;
+        std::shared_ptr<ReceiveBuffer> mBatchReceiveBuffer;
 
         void openSocket();
         void closeSocket();
@@ -49,7 +186,25 @@ namespace udpv4
         }
         uint16_t sendPacket( const ClientParameters &dest, const WireFormat & );
 
+        /*!
+         * send packets by one sendmmsg(2) call.
+         * @return count of sent packets
+         */
+        unsigned int sendPackets( const std::vector<OutgoingPacket> &packets );
+
         PacketInfo receivePacket( bool is_nonblocking = false );
+
+        /*!
+         * receive up to max_count packets by one recvmmsg(2) call.
+         * block until at least one packet arrives unless is_nonblocking is true.
+         */
+        std::vector<PacketInfo> receivePackets( unsigned int max_count = DEFAULT_BATCH_SIZE, bool is_nonblocking = false );
+
+        /*!
+         * receive up to buffer.getSlotCount() packets into buffer without heap allocation.
+         * @return count of received packets
+         */
+        unsigned int receivePackets( ReceiveBuffer &buffer, bool is_nonblocking = false );
         bool isReadable();
     };
 }
@@ -23,9 +23,12 @@ namespace dns
                                         ksk_config, zsk_config,
                                         salt, iterate, algo,
                                         enable_nsec, enable_nsec3 ) );
+        zone->setSignatureCacheSize( getServerParameters().mSignatureCacheSize );
 	dns::full::load( *zone, Domainname( apex ), config );
         zone->setup();
 	zone->verify();
+        if ( getServerParameters().mResponseCacheSize > 0 )
+            zone->enableResponseCache( getServerParameters().mResponseCacheSize );
     }
 
     std::vector<std::shared_ptr<RecordDS>> PostSignedAuthServer::getDSRecords() const
@@ -39,6 +42,19 @@ namespace dns
 	return modifyResponse( query, response, via_tcp );
     }
 
+    bool PostSignedAuthServer::generateResponse( const dns::MessageView &query, bool via_tcp, dns::MessageInfo &response ) const
+    {
+	if ( hasModifyHooks() )
+	    return false;
+	response = zone->getAnswer( query );
+	return true;
+    }
+
+    ResponseCache *PostSignedAuthServer::getResponseCache() const
+    {
+	return zone ? zone->getResponseCache() : nullptr;
+    }
+
     MessageInfo PostSignedAuthServer::modifyResponse( const dns::MessageInfo &query,
 						      const dns::MessageInfo &original_response,
                                                      bool via_tcp ) const
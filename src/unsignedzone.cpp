@@ -17,6 +17,11 @@ namespace dns
 	return mImp->getAnswer( query );
     }
 
+    MessageInfo UnsignedZone::getAnswer( const MessageView &query ) const
+    {
+	return mImp->getAnswer( query );
+    }
+
     UnsignedZone::NodePtr UnsignedZone::findNode( const Domainname &domainname ) const
     {
         return mImp->findNode( domainname );
@@ -37,6 +42,21 @@ namespace dns
 	mImp->verify();
     }
 
+    void UnsignedZone::enableResponseCache( unsigned int capacity )
+    {
+	mImp->enableResponseCache( capacity );
+    }
+
+    ResponseCache *UnsignedZone::getResponseCache() const
+    {
+	return mImp->getResponseCache();
+    }
+
+    utils::ArenaPtr UnsignedZone::getArena() const
+    {
+	return mImp->getArena();
+    }
+
     const RRSet &UnsignedZone::getSOA() const
     {
 	return mImp->getSOA();
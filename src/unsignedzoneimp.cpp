@@ -16,7 +16,7 @@ namespace dns
 	addSOAToAuthoritySection( response );
     }
 
-    void UnsignedZoneImp::responseNXDomain( const Domainname &qname, MessageInfo &response ) const
+    void UnsignedZoneImp::responseNXDomain( const Domainname &qname, MessageInfo &response, const NodeTree::LookupResult &result ) const
     {
 	response.mResponseCode = NXDOMAIN;
 	addSOAToAuthoritySection( response );
@@ -27,26 +27,24 @@ namespace dns
         responseNoData( qname, response, true );
     }
 
-    void UnsignedZoneImp::responseRRSIG( const Domainname &qname, MessageInfo &response ) const
+    void UnsignedZoneImp::responseRRSIG( const Domainname &qname, MessageInfo &response, const NodeTree::LookupResult &result ) const
     {
-	auto node = findNode( qname );
-	if ( node ) {
+	if ( result.mNode ) {
             responseNoData( qname, response, true );
 	}
 	else {
 	    // NXDOMAIN
-	    responseNXDomain( qname, response );
+	    responseNXDomain( qname, response, result );
 	}
     }
 
-    void UnsignedZoneImp::responseNSEC( const Domainname &qname, MessageInfo &response ) const
+    void UnsignedZoneImp::responseNSEC( const Domainname &qname, MessageInfo &response, const NodeTree::LookupResult &result ) const
     {
-	auto node = findNode( qname );
-	if ( node ) {
+	if ( result.mNode ) {
             responseNoData( qname, response, true );
 	}
 	else {
-	    responseNXDomain( qname, response );
+	    responseNXDomain( qname, response, result );
 	}
     }
     
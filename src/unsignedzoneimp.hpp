@@ -16,9 +16,9 @@ namespace dns
 	virtual std::vector<std::shared_ptr<RecordDS>> getDSRecords() const;
 	virtual std::shared_ptr<RRSet> signRRSet( const RRSet & ) const;
 	virtual void responseNoData( const Domainname &qname, MessageInfo &response, bool need_wildcard_nsec ) const;
-	virtual void responseNXDomain( const Domainname &qname, MessageInfo &response ) const;
-	virtual void responseRRSIG( const Domainname &qname, MessageInfo &response ) const;
-	virtual void responseNSEC( const Domainname &qname, MessageInfo &response ) const;
+	virtual void responseNXDomain( const Domainname &qname, MessageInfo &response, const NodeTree::LookupResult &result ) const;
+	virtual void responseRRSIG( const Domainname &qname, MessageInfo &response, const NodeTree::LookupResult &result ) const;
+	virtual void responseNSEC( const Domainname &qname, MessageInfo &response, const NodeTree::LookupResult &result ) const;
         virtual void responseDNSKEY( const Domainname &qname, MessageInfo &response ) const;
         virtual void addRRSIG( MessageInfo &, std::vector<ResourceRecord> &, const RRSet &original_rrset ) const;
         virtual void addRRSIG( MessageInfo &, std::vector<ResourceRecord> &, const RRSet &original_rrset, const Domainname &owner ) const;
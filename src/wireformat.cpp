@@ -1,58 +1,105 @@
 #include "wireformat.hpp"
 #include "utils.hpp"
+#include <algorithm>
 #include <cstring>
 
-WireFormat::WireFormat( uint16_t buffer_size ) : mBufferSize( buffer_size ), mEnd( 0 )
+WireFormat::WireFormat( uint16_t buffer_size )
+    : mBufferSize( buffer_size ), mEnd( 0 ), mData( mInlineBuffer ), mCapacity( INLINE_BUFFER_SIZE )
 {
 }
 
-WireFormat::WireFormat( const PacketData &data, uint16_t buffer_size ) : mBufferSize( buffer_size ), mEnd( 0 )
+WireFormat::WireFormat( const PacketData &data, uint16_t buffer_size )
+    : mBufferSize( buffer_size ), mEnd( 0 ), mData( mInlineBuffer ), mCapacity( INLINE_BUFFER_SIZE )
 {
-    for ( auto i = data.begin(); i != data.end(); i++ ) {
-        push_back( *i );
-    }
+    pushBuffer( data );
 }
 
 WireFormat::WireFormat( const uint8_t *begin, const uint8_t *end, uint16_t buffer_size )
-    : mBufferSize( buffer_size ), mEnd( 0 )
+    : mBufferSize( buffer_size ), mEnd( 0 ), mData( mInlineBuffer ), mCapacity( INLINE_BUFFER_SIZE )
 {
-    for ( auto i = begin; i != end; i++ ) {
-        push_back( *i );
-    }
+    pushBuffer( begin, end );
 }
 
 
 WireFormat::WireFormat( const WireFormat &src )
-    : mBufferSize( src.getBufferSize() ), mEnd( 0 )
+    : mBufferSize( src.getBufferSize() ), mEnd( 0 ), mData( mInlineBuffer ), mCapacity( INLINE_BUFFER_SIZE )
 {
-    for ( auto i = 0 ; i < src.size() ; i++ ) {
-        push_back( src[i] );
-    }
+    reserve( src.size() );
+    pushBuffer( src );
 }
 
 WireFormat &WireFormat::operator=( const WireFormat &src )
 {
-    for ( auto buf : mBuffers )
-	delete buf;
-    mBuffers.resize( 0 );
-    mEnd = 0;
-    mBufferSize = src.getBufferSize();
+    if ( this == &src )
+        return *this;
 
-    for ( auto i = 0 ; i < src.size() ; i++ ) {
-        push_back( src[i] );
+    clear();
+    if ( mBufferSize != src.getBufferSize() ) {
+        releaseContiguousBuffer();
+        mBufferSize = src.getBufferSize();
     }
 
+    reserve( src.size() );
+    pushBuffer( src );
+
     return *this;
 }
 
+WireFormat::WireFormat( WireFormat &&src )
+    : mBufferSize( src.getBufferSize() ), mEnd( 0 ), mData( mInlineBuffer ), mCapacity( INLINE_BUFFER_SIZE )
+{
+    moveFrom( src );
+}
+
+WireFormat &WireFormat::operator=( WireFormat &&src )
+{
+    if ( this == &src )
+        return *this;
+
+    clear();
+    releaseContiguousBuffer();
+    mBufferSize = src.getBufferSize();
+    moveFrom( src );
+
+    return *this;
+}
+
+void WireFormat::moveFrom( WireFormat &src )
+{
+    // heap buffers are taken over, and inline buffer is copied.
+    mBuffers.swap( src.mBuffers );
+    if ( src.isInlineBuffer() ) {
+        if ( src.mEnd > 0 )
+            std::memcpy( mInlineBuffer, src.mInlineBuffer, src.mEnd );
+    }
+    else {
+        mData         = src.mData;
+        mCapacity     = src.mCapacity;
+        src.mData     = src.mInlineBuffer;
+        src.mCapacity = INLINE_BUFFER_SIZE;
+    }
+    mEnd     = src.mEnd;
+    src.mEnd = 0;
+}
+
+void WireFormat::releaseContiguousBuffer()
+{
+    if ( ! isInlineBuffer() )
+        delete[] mData;
+    mData     = mInlineBuffer;
+    mCapacity = INLINE_BUFFER_SIZE;
+}
+
 
 WireFormat::~WireFormat()
 {
     clear();
+    releaseContiguousBuffer();
 }
 
 void WireFormat::clear()
 {
+    // contiguous buffer is kept to be reused.
     for ( auto i = mBuffers.begin(); i != mBuffers.end(); ++i ) {
         delete[] * i;
     }
@@ -60,6 +107,51 @@ void WireFormat::clear()
     mEnd = 0;
 }
 
+void WireFormat::truncate( uint16_t size )
+{
+    if ( size >= mEnd )
+        return;
+
+    if ( ! isContiguous() ) {
+        size_t buffer_count = ( size + mBufferSize - 1 ) / mBufferSize;
+        for ( size_t i = buffer_count ; i < mBuffers.size() ; i++ )
+            delete[] mBuffers[ i ];
+        mBuffers.resize( buffer_count );
+    }
+    mEnd = size;
+}
+
+void WireFormat::growContiguousBuffer( uint32_t size )
+{
+    if ( size > 0xffff )
+        throw std::runtime_error( "WireFormat cannot store more than 65535 bytes." );
+
+    uint32_t new_capacity = mCapacity;
+    while ( new_capacity < size )
+        new_capacity *= 2;
+
+    uint8_t *new_data = new uint8_t[ new_capacity ];
+    if ( mEnd > 0 )
+        std::memcpy( new_data, mData, mEnd );
+    releaseContiguousBuffer();
+    mData     = new_data;
+    mCapacity = new_capacity;
+}
+
+void WireFormat::pushChunkedBuffer( const uint8_t *begin, const uint8_t *end )
+{
+    while ( begin != end ) {
+        if ( mEnd % mBufferSize == 0 )
+            mBuffers.push_back( new uint8_t[ mBufferSize ] );
+
+        uint16_t offset = mEnd % mBufferSize;
+        uint16_t length = std::min<ptrdiff_t>( mBufferSize - offset, end - begin );
+        std::memcpy( mBuffers.back() + offset, begin, length );
+        begin += length;
+        mEnd  += length;
+    }
+}
+
 uint16_t WireFormat::send( int fd, const sockaddr *dest, socklen_t dest_length, int flags ) const
 {
     if ( mEnd == 0 )
@@ -67,10 +159,10 @@ uint16_t WireFormat::send( int fd, const sockaddr *dest, socklen_t dest_length,
 
     MessageHeader msg;
     msg.setDestination( dest, dest_length );
-    msg.setBuffers( mEnd, mBuffers, mBufferSize );
+    msg.setBuffers( *this );
 
 retry:
-    uint16_t sent_size = sendmsg( fd, &msg.header, flags );
+    ssize_t sent_size = sendmsg( fd, &msg.header, flags );
     if ( sent_size < 0 ) {
         if ( errno == EINTR || errno == EAGAIN )
             goto retry;
@@ -85,11 +177,10 @@ retry:
 PacketData WireFormat::get() const
 {
     PacketData ret;
-    ret.resize( size() );
-
-    for ( unsigned int i = 0; i < mEnd; i++ ) {
-        ret[ i ] = at( i );
-    }
+    ret.reserve( size() );
+    foreachBuffers( [&ret]( const uint8_t *begin, const uint8_t *end ) {
+        ret.insert( ret.end(), begin, end );
+    } );
 
     return ret;
 }
@@ -101,6 +192,9 @@ bool WireFormat::operator<( const WireFormat &rhs ) const
     else if ( size() > rhs.size() )
 	return false;
 
+    if ( isContiguous() && rhs.isContiguous() )
+        return size() > 0 && std::memcmp( mData, rhs.mData, size() ) < 0;
+
     for ( unsigned int i = 0 ; i < size() ; i++ ) {
 	if ( at( i ) < rhs.at( i ) )
 	    return true;
@@ -139,6 +233,19 @@ void WireFormat::MessageHeader::setBuffers( uint16_t size, const std::vector<uin
         header.msg_iov[ last_buffer ].iov_len = size % buffer_size;
 }
 
+void WireFormat::MessageHeader::setBuffers( const WireFormat &message )
+{
+    if ( ! message.isContiguous() ) {
+        setBuffers( message.size(), message.getBuffers(), message.getBufferSize() );
+        return;
+    }
+
+    header.msg_iov    = new iovec[ 1 ];
+    header.msg_iovlen = 1;
+    header.msg_iov[ 0 ].iov_base = const_cast<uint8_t *>( message.data() );
+    header.msg_iov[ 0 ].iov_len  = message.size();
+}
+
 void WireFormat::MessageHeader::setDestination( const sockaddr *dest, uint16_t len )
 {
     if ( dest != nullptr ) {
@@ -3,6 +3,7 @@
 
 #include <arpa/inet.h>
 #include <boost/cstdint.hpp>
+#include <cstring>
 #include <iostream>
 #include <stdexcept>
 #include <vector>
@@ -14,12 +15,26 @@
 #include <sys/socket.h>
 #include <sys/types.h>
 
+/*!
+ * buffer of DNS message.
+ * By default, data is stored in a single contiguous region which grows by doubling.
+ * The first INLINE_BUFFER_SIZE bytes are stored in the object itself without heap allocation.
+ * If buffer_size is specified, data is stored in chunks of buffer_size bytes,
+ * and the chunks are sent by scatter-gather I/O without copying.
+ */
 class WireFormat
 {
+public:
+    static const uint16_t CONTIGUOUS         = 0;
+    static const uint16_t INLINE_BUFFER_SIZE = 512;
+
 private:
     uint16_t               mBufferSize;
     uint16_t               mEnd;
     std::vector<uint8_t *> mBuffers;
+    uint8_t               *mData;
+    uint32_t               mCapacity;
+    uint8_t                mInlineBuffer[ INLINE_BUFFER_SIZE ];
 
     void checkIndex( uint16_t i ) const
     {
@@ -27,17 +42,51 @@ private:
             throw std::runtime_error( "range error" );
     }
 
+    bool isInlineBuffer() const
+    {
+        return mData == mInlineBuffer;
+    }
+
+    void growContiguousBuffer( uint32_t size );
+    void releaseContiguousBuffer();
+    void moveFrom( WireFormat &src );
+    void pushChunkedBuffer( const uint8_t *begin, const uint8_t *end );
+
 public:
-    WireFormat( uint16_t buffer_size = 512 );
-    WireFormat( const PacketData &data, uint16_t buffer_size = 512 );
-    WireFormat( const uint8_t *begin, const uint8_t *end, uint16_t buffer_size = 512 );
+    WireFormat( uint16_t buffer_size = CONTIGUOUS );
+    WireFormat( const PacketData &data, uint16_t buffer_size = CONTIGUOUS );
+    WireFormat( const uint8_t *begin, const uint8_t *end, uint16_t buffer_size = CONTIGUOUS );
     WireFormat( const WireFormat & );
+    WireFormat( WireFormat && );
     WireFormat &operator=( const WireFormat &rhs );
+    WireFormat &operator=( WireFormat &&rhs );
 
     ~WireFormat();
 
+    bool isContiguous() const
+    {
+        return mBufferSize == CONTIGUOUS;
+    }
+
+    /*!
+     * allocate size bytes in contiguous mode. nothing is done in chunked mode.
+     */
+    void reserve( uint16_t size )
+    {
+        if ( isContiguous() && size > mCapacity )
+            growContiguousBuffer( size );
+    }
+
     void push_back( uint8_t v )
     {
+        if ( isContiguous() ) {
+            if ( mEnd == mCapacity )
+                growContiguousBuffer( mEnd + 1 );
+            mData[ mEnd ] = v;
+            mEnd++;
+            return;
+        }
+
         if ( mEnd % mBufferSize == 0 )
             mBuffers.push_back( new uint8_t[ mBufferSize ] );
 
@@ -56,6 +105,11 @@ public:
 
     void clear();
 
+    /*!
+     * discard data after size bytes. It is used to roll back partially written data.
+     */
+    void truncate( uint16_t size );
+
     void pushUInt8( uint8_t v )
     {
         push_back( v );
@@ -89,26 +143,39 @@ public:
 
     void pushUInt16HtoN( uint16_t v )
     {
-        pushUInt16( htons( v ) );
+        uint16_t n = htons( v );
+        pushBuffer( reinterpret_cast<const uint8_t *>( &n ), reinterpret_cast<const uint8_t *>( &n ) + sizeof( n ) );
     }
     void pushUInt32HtoN( uint32_t v )
     {
-        pushUInt32( htonl( v ) );
+        uint32_t n = htonl( v );
+        pushBuffer( reinterpret_cast<const uint8_t *>( &n ), reinterpret_cast<const uint8_t *>( &n ) + sizeof( n ) );
     }
     void pushUInt64HtoN( uint64_t v )
     {
-        pushUInt64( htobe64( v ) );
+        uint64_t n = htobe64( v );
+        pushBuffer( reinterpret_cast<const uint8_t *>( &n ), reinterpret_cast<const uint8_t *>( &n ) + sizeof( n ) );
     }
 
     void pushBuffer( const uint8_t *begin, const uint8_t *end )
     {
-        for ( ; begin != end; begin++ )
-            push_back( *begin );
+        if ( ! isContiguous() ) {
+            pushChunkedBuffer( begin, end );
+            return;
+        }
+
+        uint32_t length = end - begin;
+        if ( length == 0 )
+            return;
+        if ( mEnd + length > mCapacity )
+            growContiguousBuffer( mEnd + length );
+        std::memcpy( mData + mEnd, begin, length );
+        mEnd += length;
     }
 
     void pushBuffer( const PacketData &data )
     {
-        pushBuffer( &data[ 0 ], &data[ 0 ] + data.size() );
+        pushBuffer( data.data(), data.data() + data.size() );
     }
 
     void pushBuffer( const std::string &str )
@@ -117,10 +184,19 @@ public:
                     reinterpret_cast<const uint8_t *>( str.c_str() ) + str.size() );
     }
 
+    void pushBuffer( const WireFormat &src )
+    {
+        src.foreachBuffers( [this]( const uint8_t *begin, const uint8_t *end ) {
+            pushBuffer( begin, end );
+        } );
+    }
+
     const uint8_t &operator[]( uint16_t i ) const
     {
         checkIndex( i );
 
+        if ( isContiguous() )
+            return mData[ i ];
         return mBuffers[ i / mBufferSize ][ i % mBufferSize ];
     }
 
@@ -128,6 +204,8 @@ public:
     {
         checkIndex( i );
 
+        if ( isContiguous() )
+            return mData[ i ];
         return mBuffers[ i / mBufferSize ][ i % mBufferSize ];
     }
 
@@ -141,6 +219,24 @@ public:
         return mEnd;
     }
 
+    /*!
+     * @return pointer to data in contiguous mode.
+     * @throw std::runtime_error in chunked mode.
+     */
+    const uint8_t *data() const
+    {
+        if ( ! isContiguous() )
+            throw std::runtime_error( "WireFormat is not contiguous." );
+        return mData;
+    }
+
+    uint8_t *data()
+    {
+        if ( ! isContiguous() )
+            throw std::runtime_error( "WireFormat is not contiguous." );
+        return mData;
+    }
+
     bool operator<( const WireFormat &rhs ) const;
     
     template <class UnaryFunction>
@@ -154,11 +250,18 @@ public:
     template <class BinaryFunction>
     void foreachBuffers ( BinaryFunction func ) const
     {
-	int last_buffer_index = mBuffers.size() - 1;
+        if ( mEnd == 0 )
+            return;
+        if ( isContiguous() ) {
+            func( mData, mData + mEnd );
+            return;
+        }
+
+	int last_buffer_index = ( mEnd - 1 ) / mBufferSize;
 	for ( int i = 0 ; i < last_buffer_index ; i++ ) {
 	    func( mBuffers[i], mBuffers[i] + mBufferSize );
 	}
-	func( mBuffers[last_buffer_index], mBuffers[last_buffer_index] + mEnd % mBufferSize );
+	func( mBuffers[last_buffer_index], mBuffers[last_buffer_index] + ( mEnd - 1 ) % mBufferSize + 1 );
     }
 
     uint16_t send( int fd, const sockaddr *dest, socklen_t dest_length, int flags = 0 ) const;
@@ -171,6 +274,7 @@ public:
         ~MessageHeader();
 	
         void setBuffers( uint16_t size, const std::vector<uint8_t *>, uint16_t buffer_size );
+        void setBuffers( const WireFormat &message );
         void setDestination( const sockaddr *dest, uint16_t len );
     };
 
@@ -178,6 +282,11 @@ public:
     {
 	return mBufferSize;
     }
+
+    const std::vector<uint8_t *> &getBuffers() const
+    {
+	return mBuffers;
+    }
 };
 
 #endif
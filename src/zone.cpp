@@ -19,15 +19,30 @@ namespace dns
         return os.str();
     }
 
+    void RRSet::compile()
+    {
+        std::vector<ConstWireRDataPtr> wire_rdata;
+        for ( auto rdata : mResourceData )
+            wire_rdata.push_back( compileRData( *rdata ) );
+        mWireRData.swap( wire_rdata );
+    }
+
     void RRSet::addResourceRecords( std::vector<ResourceRecord> &section ) const
     {
-        for ( auto rdata : mResourceData ) {
+        addResourceRecords( section, mOwner );
+    }
+
+    void RRSet::addResourceRecords( std::vector<ResourceRecord> &section, const Domainname &owner ) const
+    {
+        for ( unsigned int i = 0 ; i < mResourceData.size() ; i++ ) {
             ResourceRecord rr;
-            rr.mDomainname = mOwner;
+            rr.mDomainname = owner;
             rr.mClass      = mClass;
             rr.mType       = mType;
             rr.mTTL        = mTTL;
-            rr.mRData      = rdata;
+            rr.mRData      = mResourceData[i];
+            if ( isCompiled() )
+                rr.mWireRData = mWireRData[i];
 
             section.push_back( rr );
         }
@@ -42,9 +57,30 @@ namespace dns
 
     Node::RRSetPtr Node::find( Type t ) const
     {
-        auto rrset_itr = mRRSets.find( t );
-        if ( rrset_itr == mRRSets.end() )
-            return RRSetPtr();
-        return rrset_itr->second;
+        for ( auto &rrset : mRRSets ) {
+            if ( rrset.first == t )
+                return rrset.second;
+            if ( rrset.first > t )
+                break;
+        }
+        return RRSetPtr();
+    }
+
+    std::vector<Type> Node::getTypes() const
+    {
+        std::vector<Type> types;
+        types.reserve( mRRSets.size() );
+        for ( auto &rrset : mRRSets )
+            types.push_back( rrset.first );
+        return types;
+    }
+
+    Node &Node::add( std::shared_ptr<RRSet> rrset )
+    {
+        auto pos = std::lower_bound( mRRSets.begin(), mRRSets.end(), rrset->getType(),
+                                     []( const RRSetPair &lhs, Type rhs ) { return lhs.first < rhs; } );
+        if ( pos == mRRSets.end() || pos->first != rrset->getType() )
+            mRRSets.insert( pos, RRSetPair( rrset->getType(), rrset ) );
+        return *this;
     }
 }
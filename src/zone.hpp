@@ -2,6 +2,9 @@
 #define ZONE_HPP
 
 #include "dns.hpp"
+#include "arena.hpp"
+#include "messageview.hpp"
+#include "responsecache.hpp"
 #include <map>
 #include <vector>
 
@@ -18,7 +21,7 @@ namespace dns
     class RRSet
     {
     public:
-        typedef std::vector<RDATAPtr> RDATAContainer;
+        typedef std::vector<ConstRDATAPtr> RDATAContainer;
   
     private:
         Domainname mOwner;
@@ -26,6 +29,8 @@ namespace dns
         Type       mType;
         TTL        mTTL;
         RDATAContainer mResourceData;
+        std::vector<ConstWireRDataPtr> mWireRData; // precompiled mResourceData, or empty
+        std::shared_ptr<RRSet>         mRRSIG;     // RRSIGs generated in advance, or NULL
 
     public:
         RRSet( const Domainname &name, Class c, Type t, TTL tt )
@@ -44,23 +49,39 @@ namespace dns
         RDATAContainer::const_iterator begin() const { return mResourceData.begin(); }
         RDATAContainer::const_iterator end()   const { return mResourceData.end(); }
 
-	RDATAPtr operator[]( int index ) { return mResourceData[index]; }
 	ConstRDATAPtr operator[]( int index ) const { return mResourceData[index]; }
        	const RDATAContainer &getRRSet() const { return mResourceData; }
 
-        RRSet &add( RDATAPtr data ) { mResourceData.push_back( data ); return *this; }
+        RRSet &add( ConstRDATAPtr data ) { mResourceData.push_back( data ); mWireRData.clear(); mRRSIG.reset(); return *this; }
+
+        /*!
+         * precompile RDATA into wire format. Following add() discards the precompiled data.
+         */
+        void compile();
+        bool isCompiled() const { return ! mWireRData.empty(); }
 
         void addResourceRecords( std::vector<ResourceRecord> &section ) const;
+        void addResourceRecords( std::vector<ResourceRecord> &section, const Domainname &owner ) const;
+
+        /*!
+         * RRSIG RRSet of the RRSet signed in advance. Following add() discards it.
+         */
+        void setRRSIG( std::shared_ptr<RRSet> rrsig ) { mRRSIG = rrsig; }
+        std::shared_ptr<RRSet> getRRSIG() const { return mRRSIG; }
     };
 
     std::ostream &operator<<( std::ostream &os, const RRSet &rrset );
 
+    /*!
+     * RRSets of a node stored in a vector sorted by type.
+     * A node usually has only a few RRSets, so find() scans the vector.
+     */
     class Node
     {
     public:
         typedef std::shared_ptr<RRSet>    RRSetPtr;
-        typedef std::map<Type,  RRSetPtr> RRSetContainer;
         typedef std::pair<Type, RRSetPtr> RRSetPair;
+        typedef std::vector<RRSetPair>    RRSetContainer;
 
     private:
         RRSetContainer mRRSets;
@@ -78,7 +99,15 @@ namespace dns
         bool empty() const { return   mRRSets.empty(); }
         bool exist() const { return ! mRRSets.empty(); }
 
-        Node &add( std::shared_ptr<RRSet> rrset ) { mRRSets.insert( RRSetPair( rrset->getType(), rrset ) ); return *this; }
+        /*!
+         * @return types of RRSets in ascending order.
+         */
+        std::vector<Type> getTypes() const;
+
+        /*!
+         * add the RRSet. It is ignored if the node already has a RRSet of the same type.
+         */
+        Node &add( std::shared_ptr<RRSet> rrset );
     };
 
     class Zone
@@ -91,10 +120,27 @@ namespace dns
  
         virtual void add( std::shared_ptr<RRSet> rrset ) = 0;
         virtual MessageInfo getAnswer( const MessageInfo &query ) const = 0;
+        virtual MessageInfo getAnswer( const MessageView &query ) const = 0;
         virtual NodePtr  findNode( const Domainname &domainname ) const = 0;
         virtual RRSetPtr findRRSet( const Domainname &domainname, Type type ) const = 0;
 	virtual std::vector<std::shared_ptr<RecordDS>> getDSRecords() const = 0;
         virtual void verify() const = 0;
+
+        /*!
+         * cache responses of the zone. The cache is cleared when a RRSet is added.
+         */
+        virtual void enableResponseCache( unsigned int capacity ) = 0;
+
+        /*!
+         * @return NULL if the response cache is disabled.
+         */
+        virtual ResponseCache *getResponseCache() const = 0;
+
+        /*!
+         * @return arena for RRSets, RDATA and nodes of the zone. It is freed when the zone and
+         *         all objects allocated from it are released.
+         */
+        virtual utils::ArenaPtr getArena() const = 0;
     };
 }
 
@@ -326,6 +326,15 @@ namespace dns
 
     namespace full
     {
+        /*!
+         * allocate RDATA from the arena of the zone.
+         */
+        template <typename T, typename... Args>
+        RDATAPtr newRDATA( const utils::ArenaPtr &arena, Args&&... args )
+        {
+            return std::allocate_shared<T>( utils::ArenaAllocator<T>( arena ), std::forward<Args>( args )... );
+        }
+
         std::string eraseComment( const std::string &line )
         {
             std::string::size_type pos = line.find( ';' );
@@ -342,7 +351,7 @@ namespace dns
 	    return l;
 	}
 	
-        std::shared_ptr<RRSet> parseLine( const std::string &line )
+        ResourceRecord parseLine( const std::string &line, const utils::ArenaPtr &arena )
         {
 	    try {
 		std::vector<std::string> tokens = tokenize( line );
@@ -375,57 +384,61 @@ namespace dns
 		RDATAPtr rr;
 		switch ( type ) {
 		case TYPE_A:
-		    rr = parseRecordA( data );
+		    rr = parseRecordA( data, arena );
 		    break;
 		case TYPE_AAAA:
-		    rr = parseRecordAAAA( data );
+		    rr = parseRecordAAAA( data, arena );
 		    break;
 		case TYPE_NS:
-		    rr = parseRecordNS( data );
+		    rr = parseRecordNS( data, arena );
 		    break;
 		case TYPE_MX:
-		    rr = parseRecordMX( data );
+		    rr = parseRecordMX( data, arena );
 		    break;
 		case TYPE_SOA:
-		    rr = parseRecordSOA( data );
+		    rr = parseRecordSOA( data, arena );
 		    break;
 		case TYPE_CNAME:
-		    rr = parseRecordCNAME( data );
+		    rr = parseRecordCNAME( data, arena );
 		    break;
 		case TYPE_DNAME:
-		    rr = parseRecordDNAME( data );
+		    rr = parseRecordDNAME( data, arena );
 		    break;
 		case TYPE_TXT:
-		    rr = parseRecordTXT( data );
+		    rr = parseRecordTXT( data, arena );
 		    break;
 		case TYPE_SPF:
-		    rr = parseRecordSPF( data );
+		    rr = parseRecordSPF( data, arena );
 		    break;
 		case TYPE_CAA:
-		    rr = parseRecordCAA( data );
+		    rr = parseRecordCAA( data, arena );
 		    break;
 		case TYPE_SRV:
-		    rr = parseRecordSRV( data );
+		    rr = parseRecordSRV( data, arena );
 		    break;
 		case TYPE_RRSIG:
-		    rr = parseRecordRRSIG( data );
+		    rr = parseRecordRRSIG( data, arena );
 		    break;
 		case TYPE_DS:
-		    rr = parseRecordDS( data );
+		    rr = parseRecordDS( data, arena );
 		    break;
 		case TYPE_DNSKEY:
-		    rr = parseRecordDNSKEY( data );
+		    rr = parseRecordDNSKEY( data, arena );
 		    break;
 		case TYPE_NSEC:
-		    rr = parseRecordNSEC( data );
+		    rr = parseRecordNSEC( data, arena );
 		    break;
 		default:
 		    throw std::runtime_error( "unknown supported type" );
 		}
 
-		std::shared_ptr<RRSet> rrset( new RRSet( (Domainname)owner, CLASS_IN, type, ttl ) );
-		rrset->add( rr );
-		return rrset;
+		ResourceRecord resource_record;
+		resource_record.mDomainname = (Domainname)owner;
+		resource_record.mType       = type;
+		resource_record.mClass      = CLASS_IN;
+		resource_record.mTTL        = ttl;
+		resource_record.mRData      = rr;
+		return resource_record;
 	    }
 	    catch ( std::runtime_error &e ) {
 		std::cerr << "cannot load line \"" << line << "\" ( " << e.what() << ")." << std::endl;
@@ -461,90 +474,90 @@ namespace dns
 
 
 	
-        RDATAPtr parseRecordA( const std::vector<std::string> &data )
+        RDATAPtr parseRecordA( const std::vector<std::string> &data, const utils::ArenaPtr &arena )
         {
-            return RDATAPtr( new RecordA( data[0] ) );
+            return newRDATA<RecordA>( arena, data[0] );
         }
 
-        RDATAPtr parseRecordAAAA( const std::vector<std::string> &data )
+        RDATAPtr parseRecordAAAA( const std::vector<std::string> &data, const utils::ArenaPtr &arena )
         {
-            return RDATAPtr( new RecordAAAA( data[0] ) );
+            return newRDATA<RecordAAAA>( arena, data[0] );
         }
 
-        RDATAPtr parseRecordNS( const std::vector<std::string> &data )
+        RDATAPtr parseRecordNS( const std::vector<std::string> &data, const utils::ArenaPtr &arena )
         {
-            return RDATAPtr( new RecordNS( (Domainname)data[0] ) );
+            return newRDATA<RecordNS>( arena, (Domainname)data[0] );
         }
 
-        RDATAPtr parseRecordMX( const std::vector<std::string> &data )
+        RDATAPtr parseRecordMX( const std::vector<std::string> &data, const utils::ArenaPtr &arena )
         {
-            return RDATAPtr( new RecordMX( boost::lexical_cast<uint16_t>( data[0] ),
-                                           (Domainname)data[1] ) );
+            return newRDATA<RecordMX>( arena, boost::lexical_cast<uint16_t>( data[0] ),
+                                              (Domainname)data[1] );
         }
 
-        RDATAPtr parseRecordSOA( const std::vector<std::string> &data )
+        RDATAPtr parseRecordSOA( const std::vector<std::string> &data, const utils::ArenaPtr &arena )
         {
-            return RDATAPtr( new RecordSOA( (Domainname)data[0],                      // mname
-                                            (Domainname)data[1],                      // rname
-                                            boost::lexical_cast<uint32_t>( data[2] ), // serial
-                                            boost::lexical_cast<uint32_t>( data[3] ), // refresh
-                                            boost::lexical_cast<uint32_t>( data[4] ), // retry
-                                            boost::lexical_cast<uint32_t>( data[5] ), // expire,
-                                            boost::lexical_cast<uint32_t>( data[6] )  // minimum
-                                            ) );
+            return newRDATA<RecordSOA>( arena, (Domainname)data[0],                      // mname
+                                               (Domainname)data[1],                      // rname
+                                               boost::lexical_cast<uint32_t>( data[2] ), // serial
+                                               boost::lexical_cast<uint32_t>( data[3] ), // refresh
+                                               boost::lexical_cast<uint32_t>( data[4] ), // retry
+                                               boost::lexical_cast<uint32_t>( data[5] ), // expire,
+                                               boost::lexical_cast<uint32_t>( data[6] )  // minimum
+                                               );
         }
 
-        RDATAPtr parseRecordCNAME( const std::vector<std::string> &data )
+        RDATAPtr parseRecordCNAME( const std::vector<std::string> &data, const utils::ArenaPtr &arena )
         {
-            return RDATAPtr( new RecordCNAME( (Domainname)data[0] ) );
+            return newRDATA<RecordCNAME>( arena, (Domainname)data[0] );
         }
 
-        RDATAPtr parseRecordDNAME( const std::vector<std::string> &data )
+        RDATAPtr parseRecordDNAME( const std::vector<std::string> &data, const utils::ArenaPtr &arena )
         {
-            return RDATAPtr( new RecordDNAME( (Domainname)data[0] ) );
+            return newRDATA<RecordDNAME>( arena, (Domainname)data[0] );
         }
 
-	RDATAPtr parseRecordTXT( const std::vector<std::string> &data )
+	RDATAPtr parseRecordTXT( const std::vector<std::string> &data, const utils::ArenaPtr &arena )
         {
-            return RDATAPtr( new RecordTXT( data ) );
+            return newRDATA<RecordTXT>( arena, data );
         }
 
-	RDATAPtr parseRecordSPF( const std::vector<std::string> &data )
+	RDATAPtr parseRecordSPF( const std::vector<std::string> &data, const utils::ArenaPtr &arena )
         {
-            return RDATAPtr( new RecordSPF( data ) );
+            return newRDATA<RecordSPF>( arena, data );
         }
 
-        RDATAPtr parseRecordCAA( const std::vector<std::string> &data )
+        RDATAPtr parseRecordCAA( const std::vector<std::string> &data, const utils::ArenaPtr &arena )
         {
-            return RDATAPtr( new RecordCAA( data[1], data[2], boost::lexical_cast<uint32_t>( data[0] ) ) );
+            return newRDATA<RecordCAA>( arena, data[1], data[2], boost::lexical_cast<uint32_t>( data[0] ) );
         }
 
-        RDATAPtr parseRecordSRV( const std::vector<std::string> &data )
+        RDATAPtr parseRecordSRV( const std::vector<std::string> &data, const utils::ArenaPtr &arena )
         {
-            return RDATAPtr( new RecordSRV( boost::lexical_cast<uint16_t>( data[0] ), // priority
-					    boost::lexical_cast<uint16_t>( data[1] ), // weight
-					    boost::lexical_cast<uint16_t>( data[2] ), // port
-					    (Domainname)data[3] ) );                  // target
+            return newRDATA<RecordSRV>( arena, boost::lexical_cast<uint16_t>( data[0] ), // priority
+					       boost::lexical_cast<uint16_t>( data[1] ), // weight
+					       boost::lexical_cast<uint16_t>( data[2] ), // port
+					       (Domainname)data[3] );                    // target
         }
 
-        RDATAPtr parseRecordRRSIG( const std::vector<std::string> &data )
+        RDATAPtr parseRecordRRSIG( const std::vector<std::string> &data, const utils::ArenaPtr &arena )
         {
             auto signature_data = data.begin();
             for ( unsigned int i = 0 ; i < 8 ; i++ ) signature_data++;
             auto signature = decodeFromBase64Strings( signature_data, data.end() );
             
-            return RDATAPtr( new RecordRRSIG( stringToTypeCode( data[0] ),               // type covered
-                                              boost::lexical_cast<uint16_t>( data[1] ),  // algorithm
-                                              boost::lexical_cast<uint16_t>( data[2] ),  // label count
-                                              boost::lexical_cast<uint32_t>( data[3] ),  // original ttl
-                                              convertTimestampToEpoch( data[4] ),        // expiration
-                                              convertTimestampToEpoch( data[5] ),        // inception
-                                              boost::lexical_cast<uint16_t>( data[6] ),  // key tag
-                                              (Domainname)data[7],                       // signer
-                                              signature ) );
+            return newRDATA<RecordRRSIG>( arena, stringToTypeCode( data[0] ),               // type covered
+                                                 boost::lexical_cast<uint16_t>( data[1] ),  // algorithm
+                                                 boost::lexical_cast<uint16_t>( data[2] ),  // label count
+                                                 boost::lexical_cast<uint32_t>( data[3] ),  // original ttl
+                                                 convertTimestampToEpoch( data[4] ),        // expiration
+                                                 convertTimestampToEpoch( data[5] ),        // inception
+                                                 boost::lexical_cast<uint16_t>( data[6] ),  // key tag
+                                                 (Domainname)data[7],                       // signer
+                                                 signature );
         }
 
-        RDATAPtr parseRecordDS( const std::vector<std::string> &data )
+        RDATAPtr parseRecordDS( const std::vector<std::string> &data, const utils::ArenaPtr &arena )
         {
             std::string digest_string;
             PacketData  digest;
@@ -556,51 +569,61 @@ namespace dns
 
             decodeFromHex( digest_string, digest );
 
-            return RDATAPtr( new RecordDS( boost::lexical_cast<uint16_t>( data[0] ), // key tag
-                                           boost::lexical_cast<uint16_t>( data[1] ), // algorithm
-                                           boost::lexical_cast<uint16_t>( data[2] ), // digest type
-                                           digest ) );
+            return newRDATA<RecordDS>( arena, boost::lexical_cast<uint16_t>( data[0] ), // key tag
+                                              boost::lexical_cast<uint16_t>( data[1] ), // algorithm
+                                              boost::lexical_cast<uint16_t>( data[2] ), // digest type
+                                              digest );
         }
 
-        RDATAPtr parseRecordDNSKEY( const std::vector<std::string> &data )
+        RDATAPtr parseRecordDNSKEY( const std::vector<std::string> &data, const utils::ArenaPtr &arena )
         {
             auto public_key_data = data.begin();
             for ( int i = 0 ; i < 3 ; i++ ) public_key_data++;
             auto public_key = decodeFromBase64Strings( public_key_data, data.end() );
 
-            return RDATAPtr( new RecordDNSKEY( boost::lexical_cast<uint16_t>( data[0] ), // FLAG
-                                               boost::lexical_cast<uint16_t>( data[2] ),  // algorithm
-                                               public_key ) );                           // Public Key
+            return newRDATA<RecordDNSKEY>( arena, boost::lexical_cast<uint16_t>( data[0] ), // FLAG
+                                                  boost::lexical_cast<uint16_t>( data[2] ),  // algorithm
+                                                  public_key );                           // Public Key
         }
 
-        RDATAPtr parseRecordNSEC( const std::vector<std::string> &data )
+        RDATAPtr parseRecordNSEC( const std::vector<std::string> &data, const utils::ArenaPtr &arena )
         {
             std::vector<Type> types;
             for ( unsigned int i = 1 ; i < data.size() ; i++ ) {
                 types.push_back( stringToTypeCode( data[i] ) );
             }
-            return RDATAPtr( new RecordNSEC( (Domainname)data[0], types ) );
+            return newRDATA<RecordNSEC>( arena, (Domainname)data[0], types );
         }
 
         void load( Zone &zone, const Domainname &apex, const std::string &config )
         {
 	    boost::char_separator<char> sep( "\r\n" );
             boost::tokenizer<boost::char_separator<char>> tokens( config, sep );
+            utils::ArenaPtr arena = zone.getArena();
+            std::vector<std::shared_ptr<RRSet>> extended_rrsets; // RRSets which lost precompiled data by add()
 
             for ( auto line_pos = tokens.begin(); line_pos != tokens.end() ; line_pos++ ) {
                 std::string line = eraseLastSpace( eraseComment( *line_pos ) );
                 if ( line == "" )
                     continue;
 
-                auto new_rrset = parseLine( line );
-                auto rrset = zone.findRRSet( new_rrset->getOwner(), new_rrset->getType() );
+                ResourceRecord rr = parseLine( line, arena );
+                auto rrset = zone.findRRSet( rr.mDomainname, rr.mType );
                 if ( rrset.get() == nullptr ) {
+                    auto new_rrset = std::allocate_shared<RRSet>( utils::ArenaAllocator<RRSet>( arena ),
+                                                                  rr.mDomainname, rr.mClass, rr.mType, rr.mTTL );
+                    new_rrset->add( rr.mRData );
                     zone.add( new_rrset );
                 }
                 else {
-                    rrset->add( (*new_rrset)[0] );
+                    if ( rrset->isCompiled() )
+                        extended_rrsets.push_back( rrset );
+                    rrset->add( rr.mRData );
                 }
             }
+
+            for ( auto &rrset : extended_rrsets )
+                rrset->compile();
         }
 
     }
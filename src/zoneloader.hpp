@@ -77,24 +77,27 @@ namespace dns
 
     namespace full
     {
-        RDATAPtr parseRecordA( const std::vector<std::string> & );
-        RDATAPtr parseRecordAAAA( const std::vector<std::string> & );
-        RDATAPtr parseRecordNS( const std::vector<std::string> & );
-        RDATAPtr parseRecordMX( const std::vector<std::string> & );
-        RDATAPtr parseRecordSOA( const std::vector<std::string> & );
-        RDATAPtr parseRecordCNAME( const std::vector<std::string> & );
-        RDATAPtr parseRecordDNAME( const std::vector<std::string> & );
-        RDATAPtr parseRecordTXT( const std::vector<std::string> & );
-        RDATAPtr parseRecordSPF( const std::vector<std::string> & );
-        RDATAPtr parseRecordCAA( const std::vector<std::string> & );
-        RDATAPtr parseRecordSRV( const std::vector<std::string> & );
-        RDATAPtr parseRecordRRSIG( const std::vector<std::string> & );
-        RDATAPtr parseRecordDS( const std::vector<std::string> & );
-        RDATAPtr parseRecordDNSKEY( const std::vector<std::string> & );
-        RDATAPtr parseRecordNSEC( const std::vector<std::string> & );
+        RDATAPtr parseRecordA( const std::vector<std::string> &, const utils::ArenaPtr & );
+        RDATAPtr parseRecordAAAA( const std::vector<std::string> &, const utils::ArenaPtr & );
+        RDATAPtr parseRecordNS( const std::vector<std::string> &, const utils::ArenaPtr & );
+        RDATAPtr parseRecordMX( const std::vector<std::string> &, const utils::ArenaPtr & );
+        RDATAPtr parseRecordSOA( const std::vector<std::string> &, const utils::ArenaPtr & );
+        RDATAPtr parseRecordCNAME( const std::vector<std::string> &, const utils::ArenaPtr & );
+        RDATAPtr parseRecordDNAME( const std::vector<std::string> &, const utils::ArenaPtr & );
+        RDATAPtr parseRecordTXT( const std::vector<std::string> &, const utils::ArenaPtr & );
+        RDATAPtr parseRecordSPF( const std::vector<std::string> &, const utils::ArenaPtr & );
+        RDATAPtr parseRecordCAA( const std::vector<std::string> &, const utils::ArenaPtr & );
+        RDATAPtr parseRecordSRV( const std::vector<std::string> &, const utils::ArenaPtr & );
+        RDATAPtr parseRecordRRSIG( const std::vector<std::string> &, const utils::ArenaPtr & );
+        RDATAPtr parseRecordDS( const std::vector<std::string> &, const utils::ArenaPtr & );
+        RDATAPtr parseRecordDNSKEY( const std::vector<std::string> &, const utils::ArenaPtr & );
+        RDATAPtr parseRecordNSEC( const std::vector<std::string> &, const utils::ArenaPtr & );
     
         std::shared_ptr<RRSet> parseRRSet( const std::vector<std::string> & );
 
+        /*!
+         * load zone file. RRSets and RDATA are allocated from the arena of the zone.
+         */
         void load( Zone &zone, const Domainname &apex, const std::string &config );
     }
 
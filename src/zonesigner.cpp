@@ -25,6 +25,11 @@ namespace dns
 	return mImp->signDNSKEY( ttl );
     }
 
+    void ZoneSigner::setSignatureCacheSize( unsigned int capacity )
+    {
+	mImp->setSignatureCacheSize( capacity );
+    }
+
     std::vector<std::shared_ptr<PublicKey>> ZoneSigner::getKSKPublicKeys() const
     {
 	return mImp->getKSKPublicKeys();
@@ -73,6 +73,11 @@ namespace dns
 	std::shared_ptr<RRSet> signRRSet( const RRSet & ) const;
 	std::shared_ptr<RRSet> signDNSKEY( TTL ttl ) const;
 
+        /*!
+         * set max count of cached RRSIGs. 0 disables the cache.
+         */
+        void setSignatureCacheSize( unsigned int capacity );
+
 	std::vector<std::shared_ptr<PublicKey>> getKSKPublicKeys() const;
 	std::vector<std::shared_ptr<PublicKey>> getZSKPublicKeys() const;
 
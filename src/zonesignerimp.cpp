@@ -14,6 +14,8 @@
 
 namespace dns
 {
+    static const unsigned int DEFAULT_SIGNATURE_CACHE_SIZE = 4096;
+
     SignAlgorithm stringToSignAlgorithm( const std::string &str )
     {
 	if ( str == "RSASHA1" )
@@ -60,10 +62,10 @@ namespace dns
 
     static uint8_t getLabelCountOfCanonicalDomainname( const Domainname &name )
     {
-        unsigned int label_count = name.getLabels().size();
+        unsigned int label_count = name.getLabelCount();
         // check wildcard
         if ( label_count != 0 ) {
-            std::string label = name.getLabels()[0];
+            std::string label = name.getLabel( 0 );
             if ( label == "*" ) {
                 label_count--;
             }
@@ -253,8 +255,10 @@ namespace dns
 
 	EVP_DigestInit_ex( md_ctx, sign_algo, NULL);
 
-	PacketData digest_target = message.get();
-	int res = EVP_DigestUpdate( md_ctx, &digest_target[0], digest_target.size() );
+	int res = 1;
+	message.foreachBuffers( [md_ctx, &res]( const uint8_t *begin, const uint8_t *end ) {
+		res &= EVP_DigestUpdate( md_ctx, begin, end - begin );
+	    } );
         if ( 0 == res )
             throwException( "EVP_DigestUpdata failed" );
 	PacketData digest( EVP_MAX_MD_SIZE );
@@ -297,8 +301,10 @@ namespace dns
 
 	EVP_DigestInit_ex( md_ctx, sign_algo, NULL);
 
-	PacketData digest_target = message.get();
-	int res = EVP_DigestUpdate( md_ctx, &digest_target[0], digest_target.size() );
+	int res = 1;
+	message.foreachBuffers( [md_ctx, &res]( const uint8_t *begin, const uint8_t *end ) {
+		res &= EVP_DigestUpdate( md_ctx, begin, end - begin );
+	    } );
         if ( res != 1 ) {
 	    throwException( "EVP_DigestUpdate failed" );
         }
@@ -332,34 +338,36 @@ namespace dns
     ZoneSignerImp::ZoneSignerImp( const Domainname &apex,
 				  const std::string &ksk_filename,
 				  const std::string &zsk_filename )
-        : mApex( apex ), mMDContext( nullptr )
+        : mApex( apex ), mSignatureCacheSize( DEFAULT_SIGNATURE_CACHE_SIZE )
     {
-	try {
-	    mKSKs = PrivateKeyImp::loadConfig( ksk_filename );
-	    mZSKs = PrivateKeyImp::loadConfig( zsk_filename );
-
-	    mMDContext = EVP_MD_CTX_new();
-	    if ( ! mMDContext ) {
-		throwException( "cannot create MD_CTX" );
-	    }
-	}
-	catch ( std::runtime_error &e ) {
-	    if ( mMDContext != nullptr )
-		EVP_MD_CTX_destroy( mMDContext );
-	    throw;
-	}	
+        mKSKs = PrivateKeyImp::loadConfig( ksk_filename );
+        mZSKs = PrivateKeyImp::loadConfig( zsk_filename );
     }
 
-    ZoneSignerImp::~ZoneSignerImp()
+    void ZoneSignerImp::setSignatureCacheSize( unsigned int capacity )
     {
-        EVP_MD_CTX_destroy( mMDContext );
+        boost::mutex::scoped_lock lock( mSignatureCacheMutex );
+        mSignatureCacheSize = capacity;
+        mSignatureCache.clear();
+        mSignatureLRU.clear();
     }
 
     void ZoneSignerImp::sign( const WireFormat &message,
 			      PacketData &signature,
 			      const PrivateKeyImp &key ) const
     {
-        key.sign( mMDContext, message, signature );
+        // ZoneSignerImp is shared by server threads, so each signing uses its own context.
+        EVP_MD_CTX *md_ctx = EVP_MD_CTX_new();
+        if ( ! md_ctx )
+            throw std::runtime_error( "cannot create MD_CTX" );
+        try {
+            key.sign( md_ctx, message, signature );
+        }
+        catch ( ... ) {
+            EVP_MD_CTX_destroy( md_ctx );
+            throw;
+        }
+        EVP_MD_CTX_destroy( md_ctx );
     }
 
     void ZoneSignerImp::generateSignData( const RRSet &rrset, const PrivateKeyImp &key, WireFormat &sign_target ) const
@@ -375,10 +383,10 @@ namespace dns
 	sign_target.pushUInt16HtoN( key.getKeyTag() );                // key tag
 	key.getDomainname().outputCanonicalWireFormat( sign_target );  // signer 
 	
-	std::vector<RDATAPtr> ordered_rrs = rrset.getRRSet();
+	std::vector<ConstRDATAPtr> ordered_rrs = rrset.getRRSet();
 	std::sort( ordered_rrs.begin(),
 		   ordered_rrs.end(),
-		   []( const RDATAPtr &lhs, const RDATAPtr &rhs )
+		   []( const ConstRDATAPtr &lhs, const ConstRDATAPtr &rhs )
 		   {
 		       WireFormat lhs_data, rhs_data;
 		       lhs->outputCanonicalWireFormat( lhs_data );
@@ -398,14 +406,56 @@ namespace dns
 	}
     }
 
+    std::shared_ptr<RecordRRSIG> ZoneSignerImp::findSignature( const std::string &cache_key ) const
+    {
+        boost::mutex::scoped_lock lock( mSignatureCacheMutex );
+        auto entry = mSignatureCache.find( cache_key );
+        if ( entry == mSignatureCache.end() )
+            return std::shared_ptr<RecordRRSIG>();
+        mSignatureLRU.splice( mSignatureLRU.begin(), mSignatureLRU, entry->second );
+        return entry->second->second;
+    }
+
+    void ZoneSignerImp::addSignature( const std::string &cache_key, std::shared_ptr<RecordRRSIG> rrsig ) const
+    {
+        boost::mutex::scoped_lock lock( mSignatureCacheMutex );
+        if ( mSignatureCacheSize == 0 )
+            return;
+
+        auto entry = mSignatureCache.find( cache_key );
+        if ( entry != mSignatureCache.end() ) {
+            // another thread signed the same RRSet at the same time.
+            entry->second->second = rrsig;
+            mSignatureLRU.splice( mSignatureLRU.begin(), mSignatureLRU, entry->second );
+            return;
+        }
+
+        mSignatureLRU.push_front( SignatureCacheEntry( cache_key, rrsig ) );
+        mSignatureCache[ cache_key ] = mSignatureLRU.begin();
+        if ( mSignatureLRU.size() > mSignatureCacheSize ) {
+            mSignatureCache.erase( mSignatureLRU.back().first );
+            mSignatureLRU.pop_back();
+        }
+    }
+
     std::shared_ptr<RecordRRSIG> ZoneSignerImp::generateRRSIG( const RRSet &rrset, const PrivateKeyImp &key ) const
     {
 	WireFormat sign_target;
 	generateSignData( rrset, key, sign_target );
+
+        // sign data contains the key tag, algorithm and validity period, but keys may share the key tag.
+        const PrivateKeyImp *key_id = &key;
+        PacketData  sign_target_data = sign_target.get();
+        std::string cache_key( reinterpret_cast<const char *>( &key_id ), sizeof( key_id ) );
+        cache_key.append( sign_target_data.begin(), sign_target_data.end() );
+        std::shared_ptr<RecordRRSIG> cached_rrsig = findSignature( cache_key );
+        if ( cached_rrsig )
+            return cached_rrsig;
+
 	PacketData signature;
 	sign( sign_target, signature, key );
 
-        return std::shared_ptr<RecordRRSIG>( new RecordRRSIG( rrset.getType(),
+        std::shared_ptr<RecordRRSIG> rrsig( new RecordRRSIG( rrset.getType(),
                                                               key.getAlgorithm(),
                                                               getLabelCountOfCanonicalDomainname( rrset.getOwner() ),
                                                               rrset.getTTL(),
@@ -414,6 +464,8 @@ namespace dns
                                                               key.getKeyTag(),
                                                               key.getDomainname(),
                                                               signature ) );
+        addSignature( cache_key, rrsig );
+        return rrsig;
     }
 
     std::shared_ptr<RRSet> ZoneSignerImp::signRRSetByKeys( const RRSet &rrset, const std::vector<std::shared_ptr<PrivateKeyImp> > &keys ) const
@@ -469,10 +521,10 @@ namespace dns
         PacketData hash_target_data = hash_target.get();
 
         unsigned int digest_length = EVP_MAX_MD_SIZE;
-        EVP_DigestInit_ex( mMDContext, enumToDigestMD( algo ), NULL);
-        EVP_DigestUpdate( mMDContext, &hash_target_data[0], hash_target_data.size() );
         PacketData digest( EVP_MAX_MD_SIZE );
-        EVP_DigestFinal_ex( mMDContext, &digest[0], &digest_length );
+        if ( ! EVP_Digest( &hash_target_data[0], hash_target_data.size(),
+                           &digest[0], &digest_length, enumToDigestMD( algo ), NULL ) )
+            throw std::runtime_error( "EVP_Digest failed" );
         digest.resize( digest_length );
 
         return std::shared_ptr<RecordDS>( new RecordDS( ksk.getKeyTag(),
@@ -2,8 +2,11 @@
 #define ZONE_SIGNER_IMP_HPP
 
 #include "zonesigner.hpp"
+#include <boost/thread.hpp>
 #include <boost/utility.hpp>
+#include <list>
 #include <string>
+#include <unordered_map>
 #include <openssl/ssl.h>
 #include <openssl/evp.h>
 #include <yaml-cpp/yaml.h>
@@ -144,22 +147,40 @@ namespace dns
 
     /*!
      * ZoneSingerImp
+     * generated RRSIGs are cached by the signing key and the signed data( RRSIG RDATA except signature
+     * and canonical RRSet ), so that the same RRSet is not signed again with the same key and validity period.
+     * The key is identified by the address of PrivateKeyImp, which this signer owns for its lifetime,
+     * because keys of the same algorithm may have the same key tag.
+     * The least recently used RRSIG is evicted when the cache is full.
      */
     class ZoneSignerImp
     {
     private:
         Domainname  mApex;
-        EVP_MD_CTX *mMDContext;
 	std::vector< std::shared_ptr<PrivateKeyImp> > mKSKs;
         std::vector< std::shared_ptr<PrivateKeyImp> > mZSKs;
 
+        typedef std::pair<std::string, std::shared_ptr<RecordRRSIG>>   SignatureCacheEntry;
+        typedef std::list<SignatureCacheEntry>                          SignatureLRU; // most recently used first
+        typedef std::unordered_map<std::string, SignatureLRU::iterator> SignatureCache;
+        mutable boost::mutex   mSignatureCacheMutex;
+        mutable SignatureLRU   mSignatureLRU;
+        mutable SignatureCache mSignatureCache;
+        unsigned int           mSignatureCacheSize;
+
 	std::shared_ptr<RecordRRSIG>  generateRRSIG( const RRSet &, const PrivateKeyImp &key ) const;
+	std::shared_ptr<RecordRRSIG>  findSignature( const std::string &cache_key ) const;
+	void                          addSignature( const std::string &cache_key, std::shared_ptr<RecordRRSIG> rrsig ) const;
 	std::shared_ptr<RRSet>        signRRSetByKeys( const RRSet &, const std::vector<std::shared_ptr<PrivateKeyImp> > &keys ) const;
         std::shared_ptr<RecordDS>     getDSRecord( const PrivateKeyImp &ksk, HashAlgorithm algo ) const;
 
     public:
         ZoneSignerImp( const Domainname &d, const std::string &ksks, const std::string &zsks );
-        ~ZoneSignerImp();
+
+        /*!
+         * @param capacity max count of cached RRSIGs. 0 disables the cache.
+         */
+        void setSignatureCacheSize( unsigned int capacity );
 
 	void sign( const WireFormat &message,
 		   PacketData &signature,
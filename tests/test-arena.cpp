@@ -0,0 +1,76 @@
+#include "arena.hpp"
+#include <gtest/gtest.h>
+#include <map>
+
+class ArenaTest : public ::testing::Test
+{
+public:
+    virtual void SetUp()
+    {
+    }
+
+    virtual void TearDown()
+    {
+    }
+};
+
+TEST_F( ArenaTest, Allocate )
+{
+    utils::Arena arena( 1024 );
+
+    uint8_t *p1 = static_cast<uint8_t *>( arena.allocate( 3, 1 ) );
+    uint8_t *p2 = static_cast<uint8_t *>( arena.allocate( 8, 8 ) );
+    EXPECT_EQ( 0, reinterpret_cast<uintptr_t>( p2 ) % 8 );
+    EXPECT_LE( p1 + 3, p2 );
+    EXPECT_EQ( 1, arena.getBlockCount() );
+    EXPECT_EQ( 11, arena.getAllocatedSize() );
+
+    for ( int i = 0 ; i < 4 ; i++ )
+        arena.allocate( 250, 1 );
+    EXPECT_EQ( 1, arena.getBlockCount() );
+    arena.allocate( 250, 1 );
+    EXPECT_EQ( 2, arena.getBlockCount() );
+
+    // large object has its own block.
+    arena.allocate( 800 );
+    EXPECT_EQ( 3, arena.getBlockCount() );
+    arena.allocate( 8 );
+    EXPECT_EQ( 3, arena.getBlockCount() );
+}
+
+TEST_F( ArenaTest, AllocateShared )
+{
+    std::weak_ptr<utils::Arena> weak_arena;
+    std::shared_ptr<std::string> s;
+    {
+        utils::ArenaPtr arena( new utils::Arena );
+        weak_arena = arena;
+        s = std::allocate_shared<std::string>( utils::ArenaAllocator<std::string>( arena ), "example.com" );
+        EXPECT_LT( 0, arena->getAllocatedSize() );
+    }
+    EXPECT_FALSE( weak_arena.expired() );
+    EXPECT_EQ( "example.com", *s );
+
+    s.reset();
+    EXPECT_TRUE( weak_arena.expired() );
+}
+
+TEST_F( ArenaTest, Container )
+{
+    utils::ArenaPtr arena( new utils::Arena );
+    typedef utils::ArenaAllocator<std::pair<const int, int>> Allocator;
+    std::less<int> compare;
+    std::map<int, int, std::less<int>, Allocator> m( compare, Allocator( arena ) );
+    for ( int i = 0 ; i < 1000 ; i++ )
+        m[ i ] = i * 2;
+
+    EXPECT_EQ( 1000, m.size() );
+    EXPECT_EQ( 1998, m[ 999 ] );
+    EXPECT_LE( 1000 * sizeof( std::pair<const int, int> ), arena->getAllocatedSize() );
+}
+
+int main( int argc, char **argv )
+{
+    ::testing::InitGoogleTest( &argc, argv );
+    return RUN_ALL_TESTS();
+}
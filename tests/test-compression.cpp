@@ -237,6 +237,123 @@ TEST_F( OffsetDBTest, CompressSubDomainSize )
     EXPECT_EQ( 6, size2 );
 }
 
+TEST_F( OffsetDBTest, RestoreState )
+{
+    dns::Domainname example( "example.com" );
+    dns::Domainname test( "sub.test.net" );
+    WireFormat message;
+
+    dns::OffsetDB db;
+    db.outputWireFormat( example, message );
+    dns::OffsetDB::State state = db.getState();
+    db.outputWireFormat( test, message );
+    EXPECT_EQ( 2, db.getOutputWireFormatSize( test, message.size() ) );
+
+    message.truncate( 13 );
+    db.restoreState( state );
+    EXPECT_EQ( 13, message.size() );
+    EXPECT_EQ( 10, db.getOutputWireFormatSize( dns::Domainname( "test.net" ), message.size() ) ); // 1 + 4 + 1 + 3 + 1
+    EXPECT_EQ( 2,  db.getOutputWireFormatSize( example, message.size() ) );
+}
+
+class TruncationTest : public ::testing::Test
+{
+public:
+    dns::MessageInfo response;
+
+    virtual void SetUp()
+    {
+        response.mID            = 0x1234;
+        response.mQueryResponse = 1;
+
+        dns::QuestionSectionEntry question;
+        question.mDomainname = dns::Domainname( "www.example.com" );
+        question.mType       = dns::TYPE_A;
+        question.mClass      = dns::CLASS_IN;
+        response.mQuestionSection.push_back( question ); // 12 + 17 + 4 = 33 bytes
+
+        // 10 * ( 2 + 10 + 4 ) = 160 bytes
+        for ( int i = 0 ; i < 10 ; i++ )
+            response.mAnswerSection.push_back( generateA( "www.example.com", i ) );
+        // ( 5 + 10 + 4 ) + 4 * ( 2 + 10 + 4 ) = 83 bytes
+        for ( int i = 0 ; i < 5 ; i++ )
+            response.mAdditionalSection.push_back( generateA( "ns.example.com", i ) );
+    }
+
+    virtual void TearDown()
+    {
+    }
+
+    static dns::ResourceRecord generateA( const char *owner, int i )
+    {
+        dns::ResourceRecord rr;
+        rr.mDomainname = dns::Domainname( owner );
+        rr.mType       = dns::TYPE_A;
+        rr.mClass      = dns::CLASS_IN;
+        rr.mTTL        = 3600;
+        rr.mRData      = dns::RDATAPtr( new dns::RecordA( 0x0a000001 + i ) );
+        return rr;
+    }
+
+    static uint16_t getCount( const WireFormat &message, int index )
+    {
+        return ( message[ 4 + index * 2 ] << 8 ) + message[ 5 + index * 2 ];
+    }
+
+    static bool isTruncated( const WireFormat &message )
+    {
+        return ( message[ 2 ] & 0x02 ) != 0;
+    }
+};
+
+TEST_F( TruncationTest, NotTruncated )
+{
+    WireFormat message;
+    EXPECT_FALSE( response.generateMessage( message, 512 ) );
+
+    EXPECT_EQ( 276, message.size() );
+    EXPECT_FALSE( isTruncated( message ) );
+    EXPECT_EQ( 10, getCount( message, 1 ) );
+    EXPECT_EQ( 5,  getCount( message, 3 ) );
+}
+
+TEST_F( TruncationTest, OmitAdditionalSection )
+{
+    WireFormat message;
+    EXPECT_FALSE( response.generateMessage( message, 250 ) );
+
+    EXPECT_EQ( 193, message.size() );
+    EXPECT_FALSE( isTruncated( message ) );
+    EXPECT_EQ( 10, getCount( message, 1 ) );
+    EXPECT_EQ( 0,  getCount( message, 3 ) );
+}
+
+TEST_F( TruncationTest, TruncateAnswerSection )
+{
+    WireFormat message;
+    EXPECT_TRUE( response.generateMessage( message, 150 ) );
+
+    EXPECT_EQ( 33, message.size() );
+    EXPECT_TRUE( isTruncated( message ) );
+    EXPECT_EQ( 1, getCount( message, 0 ) );
+    EXPECT_EQ( 0, getCount( message, 1 ) );
+    EXPECT_EQ( 0, getCount( message, 3 ) );
+}
+
+TEST_F( TruncationTest, KeepOptPseudoRecord )
+{
+    response.mIsEDNS0                  = true;
+    response.mOptPseudoRR.mPayloadSize = 1232;
+
+    WireFormat message;
+    EXPECT_TRUE( response.generateMessage( message, 200 ) ); // 193 + OPT( 11 ) > 200
+
+    EXPECT_EQ( 44, message.size() );
+    EXPECT_TRUE( isTruncated( message ) );
+    EXPECT_EQ( 0, getCount( message, 1 ) );
+    EXPECT_EQ( 1, getCount( message, 3 ) );
+}
+
 int main( int argc, char **argv )
 {
     ::testing::InitGoogleTest( &argc, argv );
@@ -1,8 +1,13 @@
 #include "zonesigner.hpp"
 #include "gtest/gtest.h"
+#include <cstdio>
 #include <cstring>
+#include <fstream>
 #include <iostream>
 #include <boost/log/trivial.hpp>
+#include <openssl/ec.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
 
 
 class DNSKEYTest : public ::testing::Test
@@ -51,7 +56,60 @@ TEST_F( DNSKEYTest, CompareDNSKEY )
 }
 
 
+static void writeECDSAKey( const char *filename )
+{
+    EVP_PKEY     *key = nullptr;
+    EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new_id( EVP_PKEY_EC, nullptr );
+    ASSERT_TRUE( ctx != nullptr );
+    ASSERT_EQ( 1, EVP_PKEY_keygen_init( ctx ) );
+    ASSERT_EQ( 1, EVP_PKEY_CTX_set_ec_paramgen_curve_nid( ctx, NID_X9_62_prime256v1 ) );
+    ASSERT_EQ( 1, EVP_PKEY_keygen( ctx, &key ) );
+    EVP_PKEY_CTX_free( ctx );
+
+    FILE *fp = std::fopen( filename, "w" );
+    ASSERT_TRUE( fp != nullptr );
+    EXPECT_EQ( 1, PEM_write_PrivateKey( fp, key, nullptr, nullptr, 0, nullptr, nullptr ) );
+    std::fclose( fp );
+    EVP_PKEY_free( key );
+}
+
+static void writeKeyConfig( const char *filename, const char *type, int count )
+{
+    std::ofstream config( filename );
+    for ( int i = 0 ; i < count ; i++ ) {
+        config << "- type: " << type << "\n"
+               << "  domain: example.com\n"
+               << "  algorithm: ECDSAP256SHA256\n"
+               << "  not_before: 1500000000\n"
+               << "  not_after: 1600000000\n"
+               << "  key_file: test-dnskey-key.pem\n";
+    }
+}
 
+TEST_F( DNSKEYTest, SignatureCacheIdentifiesKey )
+{
+    dns::ZoneSigner::initialize();
+    writeECDSAKey( "test-dnskey-key.pem" );
+    writeKeyConfig( "test-dnskey-ksk.yaml", "ksk", 1 );
+    writeKeyConfig( "test-dnskey-zsk.yaml", "zsk", 2 ); // two ZSKs with the same key tag
+
+    dns::ZoneSigner signer( "example.com", "test-dnskey-ksk.yaml", "test-dnskey-zsk.yaml" );
+    dns::RRSet rrset( "www.example.com", dns::CLASS_IN, dns::TYPE_A, 3600 );
+    rrset.add( dns::RDATAPtr( new dns::RecordA( "192.168.0.1" ) ) );
+
+    std::shared_ptr<dns::RRSet> rrsigs = signer.signRRSet( rrset );
+    ASSERT_EQ( 2, rrsigs->count() );
+    EXPECT_NE( rrsigs->getRRSet()[0], rrsigs->getRRSet()[1] ) << "RRSIG of the second key must not be a cache hit";
+
+    std::shared_ptr<dns::RRSet> cached_rrsigs = signer.signRRSet( rrset );
+    ASSERT_EQ( 2, cached_rrsigs->count() );
+    EXPECT_EQ( rrsigs->getRRSet()[0], cached_rrsigs->getRRSet()[0] );
+    EXPECT_EQ( rrsigs->getRRSet()[1], cached_rrsigs->getRRSet()[1] );
+
+    std::remove( "test-dnskey-key.pem" );
+    std::remove( "test-dnskey-ksk.yaml" );
+    std::remove( "test-dnskey-zsk.yaml" );
+}
 
 int main( int argc, char **argv )
 {
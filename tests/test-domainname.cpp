@@ -1,5 +1,6 @@
 #include "dns.hpp"
 #include "gtest/gtest.h"
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 #include <boost/log/trivial.hpp>
@@ -205,6 +206,82 @@ TEST_F( DomainnameTest, CanonicalDomainname )
 }
 
 
+TEST_F( DomainnameTest, pop_and_add_labels )
+{
+    dns::Domainname name( "www.example.com" );
+
+    name.popSuffix();
+    EXPECT_STREQ( "www.example.", name.toString().c_str() );
+    name.popSubdomain();
+    EXPECT_STREQ( "example.", name.toString().c_str() );
+    name.addSubdomain( "ns" );
+    name.addSuffix( "jp" );
+    EXPECT_STREQ( "ns.example.jp.", name.toString().c_str() );
+    EXPECT_EQ( 3, name.getLabelCount() );
+    EXPECT_STREQ( "example", name.getLabel( 1 ).c_str() );
+    EXPECT_TRUE( dns::Domainname( "example.jp" ).isSubDomain( name ) );
+    EXPECT_FALSE( dns::Domainname( "ample.jp" ).isSubDomain( name ) );
+}
+
+
+TEST_F( DomainnameTest, too_long_domainname )
+{
+    dns::Domainname name;
+    std::string     label( 63, 'a' );
+    for ( int i = 0 ; i < 3 ; i++ )
+        name.addSuffix( label );
+    name.addSuffix( std::string( 61, 'b' ) );
+    EXPECT_EQ( 255, name.size() );
+
+    EXPECT_THROW( name.addSuffix( "c" ), dns::FormatError );
+    EXPECT_THROW( name.addSubdomain( std::string( 64, 'd' ) ), dns::FormatError );
+}
+
+
+TEST_F( DomainnameTest, WireFormat )
+{
+    dns::Domainname name( "www.Example.com" );
+    PacketData      wire = name.getPacket();
+    const uint8_t   expected[] = { 3, 'w', 'w', 'w', 7, 'E', 'x', 'a', 'm', 'p', 'l', 'e', 3, 'c', 'o', 'm', 0 };
+
+    ASSERT_EQ( sizeof( expected ), wire.size() );
+    EXPECT_TRUE( std::equal( wire.begin(), wire.end(), expected ) );
+
+    dns::Domainname parsed;
+    dns::Domainname::parsePacket( parsed, &wire[0], &wire[0] + wire.size(), &wire[0] );
+    EXPECT_EQ( name, parsed );
+    EXPECT_EQ( 'e', name.getCanonicalWireFormat()[5] );
+}
+
+
+TEST_F( DomainnameTest, OffsetDB )
+{
+    dns::OffsetDB   offset_db;
+    dns::OffsetDB   size_db;
+    WireFormat      message;
+    dns::Domainname www( "www.example.com" );
+    dns::Domainname mail( "mail.EXAMPLE.com" );
+    dns::Domainname net( "example.net" );
+
+    EXPECT_EQ( 17, size_db.getOutputWireFormatSize( www, 0 ) );
+    EXPECT_EQ( 7,  size_db.getOutputWireFormatSize( mail, 17 ) );
+    EXPECT_EQ( 2,  size_db.getOutputWireFormatSize( www, 24 ) );
+    EXPECT_EQ( 13, size_db.getOutputWireFormatSize( net, 26 ) );
+
+    EXPECT_EQ( 17, offset_db.outputWireFormat( www, message ) );
+    EXPECT_EQ( 7,  offset_db.outputWireFormat( mail, message ) );
+    EXPECT_EQ( 2,  offset_db.outputWireFormat( www, message ) );
+    EXPECT_EQ( 13, offset_db.outputWireFormat( net, message ) );
+
+    PacketData    data = message.get();
+    const uint8_t mail_suffix[] = { 0xC0, 4 };
+    const uint8_t www_pointer[] = { 0xC0, 0 };
+    EXPECT_TRUE( std::equal( mail_suffix, mail_suffix + 2, &data[ 22 ] ) );
+    EXPECT_TRUE( std::equal( www_pointer, www_pointer + 2, &data[ 24 ] ) );
+    EXPECT_EQ( 0, data[ 38 ] );
+}
+
+
 int main( int argc, char **argv )
 {
     ::testing::InitGoogleTest( &argc, argv );
@@ -0,0 +1,110 @@
+#include "messageview.hpp"
+#include "gtest/gtest.h"
+#include <cstring>
+#include <iostream>
+
+class MessageViewTest : public ::testing::Test
+{
+
+public:
+    virtual void SetUp()
+    {
+    }
+
+    virtual void TearDown()
+    {
+    }
+
+    PacketData generateQuery( bool is_edns0 )
+    {
+        dns::MessageInfo query;
+        query.mID               = 0x1234;
+        query.mOpcode           = dns::OPCODE_QUERY;
+        query.mRecursionDesired = 1;
+        query.mCheckingDisabled = 1;
+
+        dns::QuestionSectionEntry question;
+        question.mDomainname = dns::Domainname( "www.example.com" );
+        question.mType       = dns::TYPE_A;
+        question.mClass      = dns::CLASS_IN;
+        query.mQuestionSection.push_back( question );
+
+        if ( is_edns0 ) {
+            query.mIsEDNS0                  = true;
+            query.mOptPseudoRR.mPayloadSize = 4096;
+            query.mOptPseudoRR.mDOBit       = true;
+        }
+
+        WireFormat message;
+        query.generateMessage( message );
+        return message.get();
+    }
+};
+
+TEST_F( MessageViewTest, Question )
+{
+    PacketData message = generateQuery( false );
+    dns::MessageView view( message.data(), message.data() + message.size() );
+
+    EXPECT_EQ( 0x1234, view.getID() );
+    EXPECT_EQ( 0, view.getQueryResponse() );
+    EXPECT_EQ( dns::OPCODE_QUERY, view.getOpcode() );
+    EXPECT_TRUE( view.getRecursionDesired() );
+    EXPECT_TRUE( view.getCheckingDisabled() );
+    EXPECT_EQ( 1, view.getQuestionCount() );
+    EXPECT_TRUE( view.hasQuestion() );
+    EXPECT_EQ( dns::Domainname( "www.example.com" ), view.getQuestionDomainname() );
+    EXPECT_EQ( dns::TYPE_A, view.getQuestionType() );
+    EXPECT_EQ( dns::CLASS_IN, view.getQuestionClass() );
+    EXPECT_FALSE( view.isEDNS0() );
+    EXPECT_FALSE( view.isTSIG() );
+}
+
+TEST_F( MessageViewTest, EDNS0 )
+{
+    PacketData message = generateQuery( true );
+    dns::MessageView view( message.data(), message.data() + message.size() );
+
+    EXPECT_TRUE( view.isEDNS0() );
+    EXPECT_EQ( 4096, view.getPayloadSize() );
+    EXPECT_EQ( 0, view.getEDNSVersion() );
+    EXPECT_TRUE( view.getDOBit() );
+    EXPECT_TRUE( view.isDNSSECOK() );
+}
+
+TEST_F( MessageViewTest, MessageInfo )
+{
+    PacketData message = generateQuery( true );
+    dns::MessageView view( message.data(), message.data() + message.size() );
+    dns::MessageInfo info = view.getMessageInfo();
+
+    EXPECT_EQ( view.getID(), info.mID );
+    EXPECT_EQ( view.getQuestionDomainname(), info.mQuestionSection[0].mDomainname );
+    EXPECT_EQ( view.getPayloadSize(), info.mOptPseudoRR.mPayloadSize );
+}
+
+TEST_F( MessageViewTest, ShortMessage )
+{
+    PacketData message = generateQuery( true );
+
+    EXPECT_THROW( { dns::MessageView view( message.data(), message.data() + 11 ); }, dns::FormatError );
+    for ( unsigned int size = 12 ; size < message.size() ; size++ ) {
+        EXPECT_THROW( { dns::MessageView view( message.data(), message.data() + size ); }, dns::FormatError )
+            << "message size: " << size;
+    }
+}
+
+TEST_F( MessageViewTest, BadCompressionPointer )
+{
+    PacketData message = generateQuery( false );
+    message[ 12 ] = 0xc0;
+    message[ 13 ] = 0xff;
+
+    EXPECT_THROW( { dns::MessageView view( message.data(), message.data() + message.size() ); }, dns::FormatError );
+}
+
+int main( int argc, char **argv )
+{
+    ::testing::InitGoogleTest( &argc, argv );
+    return RUN_ALL_TESTS();
+}
@@ -40,6 +40,7 @@ public:
         mNSECDB.addNode( "example.com",      *apex_node );
         mNSECDB.addNode( "www.example.com",  *www_node );
         mNSECDB.addNode( "mail.example.com", *mail_node );
+        mNSECDB.freeze( 300 );
     }
 
     virtual void TearDown()
@@ -56,7 +57,7 @@ TEST_F( NSECDBTest, find )
     EXPECT_EQ( dns::TYPE_NSEC,    nsec_rr.mType );
     EXPECT_EQ( 300,               nsec_rr.mTTL );
 
-    auto nsec_rd = std::dynamic_pointer_cast<dns::RecordNSEC>( nsec_rr.mRData );
+    auto nsec_rd = std::dynamic_pointer_cast<const dns::RecordNSEC>( nsec_rr.mRData );
             
     EXPECT_EQ( "example.com",   nsec_rd->getNextDomainname() );
     EXPECT_EQ( 3,               nsec_rd->getTypes().size() );   // A, NSEC, RRSIG
@@ -73,7 +74,7 @@ TEST_F( NSECDBTest, find_for_2 )
     EXPECT_EQ( dns::TYPE_NSEC,    nsec_rr.mType );
     EXPECT_EQ( 300,               nsec_rr.mTTL );
 
-    auto nsec_rd = std::dynamic_pointer_cast<dns::RecordNSEC>( nsec_rr.mRData );
+    auto nsec_rd = std::dynamic_pointer_cast<const dns::RecordNSEC>( nsec_rr.mRData );
             
     EXPECT_EQ( "www.example.com", nsec_rd->getNextDomainname() );
     EXPECT_EQ( 3,                 nsec_rd->getTypes().size() );
@@ -90,7 +91,7 @@ TEST_F( NSECDBTest, find_for_wildcard )
     EXPECT_EQ( dns::TYPE_NSEC, nsec_rr.mType );
     EXPECT_EQ( 300,            nsec_rr.mTTL );
 
-    auto nsec_rd = std::dynamic_pointer_cast<dns::RecordNSEC>( nsec_rr.mRData );
+    auto nsec_rd = std::dynamic_pointer_cast<const dns::RecordNSEC>( nsec_rr.mRData );
             
     EXPECT_EQ( "mail.example.com.", nsec_rd->getNextDomainname() );
     EXPECT_EQ( 5,                   nsec_rd->getTypes().size() ); // SOA + NS + MX + NSEC + RRSIG
@@ -104,7 +105,7 @@ TEST_F( NSECDBTest, find_for_nodata )
     EXPECT_EQ( dns::TYPE_NSEC,     nsec_rr.mType );
     EXPECT_EQ( 300,                nsec_rr.mTTL );
 
-    auto nsec_rd = std::dynamic_pointer_cast<dns::RecordNSEC>( nsec_rr.mRData );
+    auto nsec_rd = std::dynamic_pointer_cast<const dns::RecordNSEC>( nsec_rr.mRData );
             
     EXPECT_EQ( "www.example.com", nsec_rd->getNextDomainname() );
     EXPECT_EQ( 3,                 nsec_rd->getTypes().size() ); // A, NSEC, RRSIG
@@ -118,12 +119,34 @@ TEST_F( NSECDBTest, find_for_nodata_last )
     EXPECT_EQ( dns::TYPE_NSEC,    nsec_rr.mType );
     EXPECT_EQ( 300,               nsec_rr.mTTL );
 
-    auto nsec_rd = std::dynamic_pointer_cast<dns::RecordNSEC>( nsec_rr.mRData );
+    auto nsec_rd = std::dynamic_pointer_cast<const dns::RecordNSEC>( nsec_rr.mRData );
             
     EXPECT_EQ( "example.com", nsec_rd->getNextDomainname() );
     EXPECT_EQ( 3,             nsec_rd->getTypes().size() ); // A, NSEC, RRSIG
 }
 
+TEST_F( NSECDBTest, find_rrset )
+{
+    auto nsec = mNSECDB.findRRSet( "wwww.example.com" );
+    EXPECT_EQ( "www.example.com", nsec->getOwner() );
+    EXPECT_EQ( dns::TYPE_NSEC,    nsec->getType() );
+    EXPECT_EQ( 300,               nsec->getTTL() );
+    EXPECT_EQ( 1,                 nsec->count() );
+
+    EXPECT_EQ( nsec, mNSECDB.findRRSet( "www.example.com" ) ) << "NSEC RRSet is shared";
+    EXPECT_EQ( nsec, mNSECDB.findRRSet( "WWW.EXAMPLE.COM" ) );
+    EXPECT_EQ( nsec, mNSECDB.findRRSet( "a.example.net" ) )  << "name after the last owner";
+
+    dns::Node node;
+    EXPECT_THROW( { mNSECDB.addNode( "ftp.example.com", node ); }, std::logic_error );
+}
+
+TEST_F( NSECDBTest, not_frozen )
+{
+    dns::NSECDB db( "example.com" );
+    EXPECT_THROW( { db.findRRSet( "www.example.com" ); }, std::logic_error );
+}
+
 
 
 int main( int argc, char **argv )
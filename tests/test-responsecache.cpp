@@ -0,0 +1,137 @@
+#include "responsecache.hpp"
+#include "gtest/gtest.h"
+#include <iostream>
+
+class ResponseCacheTest : public ::testing::Test
+{
+
+public:
+    virtual void SetUp()
+    {
+    }
+
+    virtual void TearDown()
+    {
+    }
+
+    PacketData generateQuery( uint16_t id, const char *qname, bool is_edns0 )
+    {
+        dns::MessageInfo query;
+        query.mID               = id;
+        query.mOpcode           = dns::OPCODE_QUERY;
+        query.mRecursionDesired = 1;
+
+        dns::QuestionSectionEntry question;
+        question.mDomainname = dns::Domainname( qname );
+        question.mType       = dns::TYPE_A;
+        question.mClass      = dns::CLASS_IN;
+        query.mQuestionSection.push_back( question );
+
+        if ( is_edns0 ) {
+            query.mIsEDNS0                  = true;
+            query.mOptPseudoRR.mPayloadSize = 1232;
+            query.mOptPseudoRR.mDOBit       = true;
+        }
+
+        WireFormat message;
+        query.generateMessage( message );
+        return message.get();
+    }
+
+    void generateResponse( const PacketData &query_data, WireFormat &response )
+    {
+        dns::MessageInfo query = dns::parseDNSMessage( query_data.data(), query_data.data() + query_data.size() );
+        dns::MessageInfo info;
+        info.mID                  = query.mID;
+        info.mQueryResponse       = 1;
+        info.mOpcode              = dns::OPCODE_QUERY;
+        info.mAuthoritativeAnswer = 1;
+        info.mRecursionDesired    = query.mRecursionDesired;
+        info.mQuestionSection     = query.mQuestionSection;
+        info.mIsEDNS0             = query.mIsEDNS0;
+        info.mOptPseudoRR         = query.mOptPseudoRR;
+
+        dns::ResourceRecord rr;
+        rr.mDomainname = query.mQuestionSection[ 0 ].mDomainname;
+        rr.mType       = dns::TYPE_A;
+        rr.mClass      = dns::CLASS_IN;
+        rr.mTTL        = 3600;
+        rr.mRData      = dns::RDATAPtr( new dns::RecordA( "192.168.0.1" ) );
+        info.mAnswerSection.push_back( rr );
+
+        info.generateMessage( response );
+    }
+};
+
+TEST_F( ResponseCacheTest, FindPatchesIDAndQNAME )
+{
+    dns::ResponseCache cache( 16 );
+
+    PacketData query1 = generateQuery( 0x1234, "www.example.com", true );
+    dns::MessageView view1( query1.data(), query1.data() + query1.size() );
+    WireFormat response1;
+    generateResponse( query1, response1 );
+
+    WireFormat found;
+    EXPECT_FALSE( cache.find( view1, found ) );
+    cache.insert( view1, response1 );
+
+    PacketData query2 = generateQuery( 0x5678, "WWW.Example.COM", true );
+    dns::MessageView view2( query2.data(), query2.data() + query2.size() );
+    ASSERT_TRUE( cache.find( view2, found ) );
+
+    PacketData       data = found.get();
+    dns::MessageInfo info = dns::parseDNSMessage( data.data(), data.data() + data.size() );
+    EXPECT_EQ( 0x5678, info.mID );
+    ASSERT_EQ( 1, info.mQuestionSection.size() );
+    EXPECT_EQ( "WWW.Example.COM.", info.mQuestionSection[ 0 ].mDomainname.toString() );
+    ASSERT_EQ( 1, info.mAnswerSection.size() );
+    EXPECT_EQ( "192.168.0.1", info.mAnswerSection[ 0 ].mRData->toString() );
+}
+
+TEST_F( ResponseCacheTest, DifferentEDNS0 )
+{
+    dns::ResponseCache cache( 16 );
+
+    PacketData query1 = generateQuery( 0x1234, "www.example.com", true );
+    dns::MessageView view1( query1.data(), query1.data() + query1.size() );
+    WireFormat response1;
+    generateResponse( query1, response1 );
+    cache.insert( view1, response1 );
+
+    PacketData query2 = generateQuery( 0x1234, "www.example.com", false );
+    dns::MessageView view2( query2.data(), query2.data() + query2.size() );
+    WireFormat found;
+    EXPECT_FALSE( cache.find( view2, found ) );
+}
+
+TEST_F( ResponseCacheTest, NotCacheable )
+{
+    PacketData query = generateQuery( 0x1234, "www.example.com", false );
+    query[ 2 ] |= 0x80; // QR
+    dns::MessageView view( query.data(), query.data() + query.size() );
+
+    EXPECT_FALSE( dns::ResponseCache::isCacheable( view ) );
+}
+
+TEST_F( ResponseCacheTest, Clear )
+{
+    dns::ResponseCache cache( 16 );
+
+    PacketData query = generateQuery( 0x1234, "www.example.com", false );
+    dns::MessageView view( query.data(), query.data() + query.size() );
+    WireFormat response;
+    generateResponse( query, response );
+    cache.insert( view, response );
+
+    WireFormat found;
+    EXPECT_TRUE( cache.find( view, found ) );
+    cache.clear();
+    EXPECT_FALSE( cache.find( view, found ) );
+}
+
+int main( int argc, char **argv )
+{
+    ::testing::InitGoogleTest( &argc, argv );
+    return RUN_ALL_TESTS();
+}
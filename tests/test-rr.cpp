@@ -119,6 +119,34 @@ TEST_F( RRTest, OutputRecordNS )
 }
 
 
+TEST_F( RRTest, ShareRData )
+{
+    dns::ResourceRecord rr;
+    rr.mDomainname = "example.com";
+    rr.mType = dns::TYPE_A;
+    rr.mClass = dns::CLASS_IN;
+    rr.mRData = dns::RDATAPtr( new dns::RecordA( "127.0.0.1" ) );
+
+    dns::ResourceRecord copy = rr;
+    EXPECT_EQ( rr.mRData.get(), copy.mRData.get() );
+}
+
+TEST_F( RRTest, CopyOnWriteOptions )
+{
+    dns::MessageInfo message;
+    message.mIsEDNS0 = true;
+    message.addOption( dns::OptPseudoRROptPtr( new dns::NSIDOption( "ns1" ) ) );
+
+    dns::MessageInfo copy = message;
+    copy.addOption( dns::OptPseudoRROptPtr( new dns::NSIDOption( "ns2" ) ) );
+
+    auto options      = std::dynamic_pointer_cast<const dns::RecordOptionsData>( message.mOptPseudoRR.mOptions );
+    auto copy_options = std::dynamic_pointer_cast<const dns::RecordOptionsData>( copy.mOptPseudoRR.mOptions );
+    EXPECT_EQ( 1, options->getOptions().size() );
+    EXPECT_EQ( 2, copy_options->getOptions().size() );
+    EXPECT_EQ( options->getOptions()[0].get(), copy_options->getOptions()[0].get() );
+}
+
 int main( int argc, char **argv )
 {
     ::testing::InitGoogleTest( &argc, argv );
@@ -0,0 +1,226 @@
+#include "threadpool.hpp"
+#include "mpmcqueue.hpp"
+#include "gtest/gtest.h"
+#include <atomic>
+#include <boost/thread.hpp>
+
+class ThreadPoolTest : public ::testing::Test
+{
+
+public:
+    virtual void SetUp()
+    {
+    }
+
+    virtual void TearDown()
+    {
+    }
+};
+
+TEST_F( ThreadPoolTest, MPMCQueueCapacity )
+{
+    utils::MPMCQueue<int> queue( 3 );
+    EXPECT_EQ( 4, queue.capacity() );
+
+    EXPECT_TRUE( queue.push( 1 ) );
+    EXPECT_TRUE( queue.push( 2 ) );
+    EXPECT_TRUE( queue.push( 3 ) );
+    EXPECT_TRUE( queue.push( 4 ) );
+    EXPECT_FALSE( queue.push( 5 ) );
+    EXPECT_EQ( 4, queue.size() );
+
+    int v;
+    EXPECT_TRUE( queue.pop( v ) );
+    EXPECT_EQ( 1, v );
+    EXPECT_TRUE( queue.push( 5 ) );
+    for ( int i = 2 ; i <= 5 ; i++ ) {
+        EXPECT_TRUE( queue.pop( v ) );
+        EXPECT_EQ( i, v );
+    }
+    EXPECT_FALSE( queue.pop( v ) );
+}
+
+static void produce( utils::MPMCQueue<int> *queue, int begin, int end )
+{
+    for ( int i = begin ; i < end ; i++ ) {
+        while ( ! queue->push( i ) )
+            boost::this_thread::yield();
+    }
+}
+
+static void consume( utils::MPMCQueue<int> *queue, int count, std::atomic<long> *sum )
+{
+    for ( int i = 0 ; i < count ; i++ ) {
+        int v;
+        while ( ! queue->pop( v ) )
+            boost::this_thread::yield();
+        *sum += v;
+    }
+}
+
+TEST_F( ThreadPoolTest, MPMCQueueMultiThread )
+{
+    const int THREAD_COUNT = 4;
+    const int COUNT        = 10000;
+
+    utils::MPMCQueue<int> queue( 64 );
+    std::atomic<long>     sum( 0 );
+    boost::thread_group   threads;
+    for ( int i = 0 ; i < THREAD_COUNT ; i++ ) {
+        threads.create_thread( boost::bind( produce, &queue, i * COUNT, ( i + 1 ) * COUNT ) );
+        threads.create_thread( boost::bind( consume, &queue, COUNT, &sum ) );
+    }
+    threads.join_all();
+
+    long n = THREAD_COUNT * COUNT;
+    EXPECT_EQ( n * ( n - 1 ) / 2, sum );
+}
+
+static void increment( std::atomic<int> *counter )
+{
+    ( *counter )++;
+}
+
+TEST_F( ThreadPoolTest, StopAfterProcessingAllRequests )
+{
+    std::atomic<int>  counter( 0 );
+    utils::ThreadPool pool( 4, 16 );
+    pool.start();
+
+    for ( int i = 0 ; i < 1000 ; i++ )
+        EXPECT_TRUE( pool.submit( boost::bind( increment, &counter ) ) );
+
+    pool.stop();
+    pool.join();
+    EXPECT_EQ( 1000, counter );
+    EXPECT_FALSE( pool.submit( boost::bind( increment, &counter ) ) );
+}
+
+TEST_F( ThreadPoolTest, TrySubmitToFullQueue )
+{
+    std::atomic<int>  counter( 0 );
+    utils::ThreadPool pool( 1, 2 );
+
+    EXPECT_TRUE( pool.trySubmit( boost::bind( increment, &counter ) ) );
+    EXPECT_TRUE( pool.trySubmit( boost::bind( increment, &counter ) ) );
+    EXPECT_FALSE( pool.trySubmit( boost::bind( increment, &counter ) ) );
+
+    pool.start();
+    pool.stop();
+    pool.join();
+    EXPECT_EQ( 2, counter );
+}
+
+TEST_F( ThreadPoolTest, WorkStealingStopAfterProcessingAllRequests )
+{
+    std::atomic<int>               counter( 0 );
+    utils::WorkStealingThreadPool pool( 4, 16, true );
+    pool.start();
+
+    for ( int i = 0 ; i < 1000 ; i++ )
+        EXPECT_TRUE( pool.submit( boost::bind( increment, &counter ) ) );
+
+    pool.stop();
+    pool.join();
+    EXPECT_EQ( 1000, counter );
+    EXPECT_FALSE( pool.submit( boost::bind( increment, &counter ) ) );
+}
+
+static void submitFromWorker( utils::AbstractThreadPool *pool, std::atomic<int> *counter, int depth )
+{
+    ( *counter )++;
+    if ( depth > 0 ) {
+        pool->submit( boost::bind( submitFromWorker, pool, counter, depth - 1 ) );
+        pool->submit( boost::bind( submitFromWorker, pool, counter, depth - 1 ) );
+    }
+}
+
+TEST_F( ThreadPoolTest, WorkStealingSubmitFromWorker )
+{
+    std::atomic<int>               counter( 0 );
+    utils::WorkStealingThreadPool pool( 4 );
+    pool.start();
+
+    pool.submit( boost::bind( submitFromWorker, &pool, &counter, 9 ) );
+    while ( counter < 1023 )
+        boost::this_thread::yield();
+
+    pool.stop();
+    pool.join();
+    EXPECT_EQ( 1023, counter );
+}
+
+TEST_F( ThreadPoolTest, WorkStealingTrySubmitToFullQueue )
+{
+    std::atomic<int>               counter( 0 );
+    utils::WorkStealingThreadPool pool( 2, 2 );
+
+    EXPECT_TRUE( pool.trySubmit( boost::bind( increment, &counter ) ) );
+    EXPECT_TRUE( pool.trySubmit( boost::bind( increment, &counter ) ) );
+    EXPECT_FALSE( pool.trySubmit( boost::bind( increment, &counter ) ) );
+
+    pool.start();
+    pool.stop();
+    pool.join();
+    EXPECT_EQ( 2, counter );
+}
+
+static void record( boost::mutex *mutex, std::vector<int> *order, int value )
+{
+    boost::mutex::scoped_lock lock( *mutex );
+    order->push_back( value );
+}
+
+TEST_F( ThreadPoolTest, WorkStealingExternalRequestsInFIFOOrder )
+{
+    boost::mutex                  mutex;
+    std::vector<int>              order;
+    utils::WorkStealingThreadPool pool( 1, 16 );
+
+    for ( int i = 0 ; i < 10 ; i++ )
+        EXPECT_TRUE( pool.submit( boost::bind( record, &mutex, &order, i ) ) );
+    pool.start();
+    pool.stop();
+    pool.join();
+
+    ASSERT_EQ( 10, order.size() );
+    for ( int i = 0 ; i < 10 ; i++ )
+        EXPECT_EQ( i, order[ i ] );
+}
+
+static void block( std::atomic<bool> *is_started, std::atomic<bool> *is_released )
+{
+    *is_started = true;
+    while ( ! *is_released )
+        boost::this_thread::yield();
+}
+
+TEST_F( ThreadPoolTest, WorkStealingStealExternalRequests )
+{
+    std::atomic<int>              counter( 0 );
+    std::atomic<bool>             is_started( false ), is_released( false );
+    utils::WorkStealingThreadPool pool( 2, 16 );
+    pool.start();
+
+    EXPECT_TRUE( pool.submit( boost::bind( block, &is_started, &is_released ) ) );
+    while ( ! is_started )
+        boost::this_thread::yield();
+
+    // requests are spread over both workers, so the free worker must steal those of the blocked one.
+    for ( int i = 0 ; i < 10 ; i++ )
+        EXPECT_TRUE( pool.submit( boost::bind( increment, &counter ) ) );
+    while ( counter < 10 )
+        boost::this_thread::yield();
+    EXPECT_LT( 0, pool.getStolenCount() );
+
+    is_released = true;
+    pool.stop();
+    pool.join();
+    EXPECT_EQ( 10, counter );
+}
+
+int main( int argc, char **argv )
+{
+    ::testing::InitGoogleTest( &argc, argv );
+    return RUN_ALL_TESTS();
+}
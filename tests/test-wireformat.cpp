@@ -462,6 +462,84 @@ TEST_F( WireFormatTest, copy_size_n )
     }
 }
 
+TEST_F( WireFormatTest, contiguous_push_buffer )
+{
+    WireFormat msg;
+    uint8_t data[ 1000 ];
+    for ( unsigned int i = 0 ; i < sizeof( data ) ; i++ )
+        data[ i ] = i & 0xff;
+
+    msg.pushUInt16HtoN( 0x0102 );
+    msg.pushBuffer( data, data + sizeof( data ) );
+
+    EXPECT_TRUE( msg.isContiguous() );
+    EXPECT_EQ( 2 + sizeof( data ), msg.size() );
+    EXPECT_EQ( 0x01, msg.data()[ 0 ] );
+    EXPECT_EQ( 0x02, msg.data()[ 1 ] );
+    EXPECT_EQ( 0, std::memcmp( data, msg.data() + 2, sizeof( data ) ) );
+    EXPECT_THROW( { msg[ 2 + sizeof( data ) ]; }, std::runtime_error );
+}
+
+TEST_F( WireFormatTest, chunked_data )
+{
+    WireFormat msg( 4 );
+    msg.push_back( 0 );
+
+    EXPECT_FALSE( msg.isContiguous() );
+    EXPECT_THROW( { msg.data(); }, std::runtime_error );
+}
+
+TEST_F( WireFormatTest, copy_chunked_to_contiguous )
+{
+    uint8_t data[] = {0, 1, 2, 3, 4, 5, 6, 7};
+    WireFormat src( data, data + sizeof( data ), 4 );
+    WireFormat dst;
+    dst.pushBuffer( src );
+
+    EXPECT_EQ( sizeof( data ), dst.size() );
+    EXPECT_EQ( 0, std::memcmp( data, dst.data(), sizeof( data ) ) );
+    EXPECT_EQ( src.get(), dst.get() );
+}
+
+TEST_F( WireFormatTest, move_inline_buffer )
+{
+    uint8_t data[] = {0, 1, 2, 3};
+    WireFormat src( data, data + sizeof( data ) );
+    WireFormat dst( std::move( src ) );
+
+    EXPECT_EQ( 0, src.size() );
+    EXPECT_EQ( sizeof( data ), dst.size() );
+    EXPECT_EQ( 0, std::memcmp( data, dst.data(), sizeof( data ) ) );
+}
+
+TEST_F( WireFormatTest, move_heap_buffer )
+{
+    PacketData data( WireFormat::INLINE_BUFFER_SIZE * 2, 0x5a );
+    WireFormat src( data );
+    const uint8_t *src_data = src.data();
+
+    WireFormat dst;
+    dst = std::move( src );
+
+    EXPECT_EQ( 0, src.size() );
+    EXPECT_EQ( src_data, dst.data() ) << "heap buffer is taken over";
+    EXPECT_EQ( data, dst.get() );
+
+    src.pushUInt8( 1 );
+    EXPECT_EQ( 1, src.size() );
+}
+
+TEST_F( WireFormatTest, move_chunked )
+{
+    uint8_t data[] = {0, 1, 2, 3, 4};
+    WireFormat src( data, data + sizeof( data ), 4 );
+    WireFormat dst( std::move( src ) );
+
+    EXPECT_EQ( 0, src.size() );
+    EXPECT_EQ( 4, dst.getBufferSize() );
+    EXPECT_EQ( PacketData( data, data + sizeof( data ) ), dst.get() );
+}
+
 
 int main( int argc, char **argv )
 {
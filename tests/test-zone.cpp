@@ -1,4 +1,5 @@
 #include "unsignedzone.hpp"
+#include "nodetree.hpp"
 #include "gtest/gtest.h"
 #include <cstring>
 #include <iostream>
@@ -30,6 +31,50 @@ TEST_F( RRSetTest, AddRRData )
     EXPECT_STREQ( "192.168.0.2", (*a)->toString().c_str() );
 }
 
+TEST_F( RRSetTest, CompiledRRSet )
+{
+    dns::RRSet rrset( "example.com", dns::CLASS_IN, dns::TYPE_NS, 3600 );
+    rrset.add( dns::RDATAPtr( new dns::RecordNS( "ns01.example.com" ) ) );
+    rrset.add( dns::RDATAPtr( new dns::RecordNS( "ns02.example.net" ) ) );
+
+    std::vector<dns::ResourceRecord> records, compiled_records;
+    rrset.addResourceRecords( records );
+    rrset.compile();
+    EXPECT_TRUE( rrset.isCompiled() );
+    rrset.addResourceRecords( compiled_records );
+    ASSERT_TRUE( compiled_records[0].mWireRData.get() != nullptr );
+    EXPECT_EQ( 1, compiled_records[0].mWireRData->mNames.size() );
+
+    WireFormat    message, compiled_message;
+    dns::OffsetDB offset_db, compiled_offset_db;
+    for ( unsigned int i = 0 ; i < records.size() ; i++ ) {
+        dns::generateResourceRecord( records[i], message, offset_db );
+        dns::generateResourceRecord( compiled_records[i], compiled_message, compiled_offset_db );
+    }
+    EXPECT_EQ( message.get(), compiled_message.get() );
+    EXPECT_EQ( 13 + 10 + 7 + 2 + 10 + 18, compiled_message.size() ); // ns01 is compressed, ns02.example.net is not.
+
+    rrset.add( dns::RDATAPtr( new dns::RecordNS( "ns03.example.com" ) ) );
+    EXPECT_FALSE( rrset.isCompiled() );
+}
+
+TEST_F( RRSetTest, StoredRRSIG )
+{
+    dns::RRSet rrset( "example.com", dns::CLASS_IN, dns::TYPE_NS, 3600 );
+    rrset.add( dns::RDATAPtr( new dns::RecordNS( "ns01.example.com" ) ) );
+    EXPECT_FALSE( rrset.getRRSIG() );
+
+    std::shared_ptr<dns::RRSet> rrsig( new dns::RRSet( "example.com", dns::CLASS_IN, dns::TYPE_RRSIG, 3600 ) );
+    rrset.setRRSIG( rrsig );
+    EXPECT_EQ( rrsig, rrset.getRRSIG() );
+
+    dns::RRSet copied( rrset );
+    EXPECT_EQ( rrsig, copied.getRRSIG() );
+
+    rrset.add( dns::RDATAPtr( new dns::RecordNS( "ns02.example.com" ) ) );
+    EXPECT_FALSE( rrset.getRRSIG() );
+}
+
 
 class NodeTest : public ::testing::Test
 {
@@ -68,6 +113,104 @@ TEST_F( NodeTest, AddSet )
 
 }
 
+TEST_F( NodeTest, SortedTypes )
+{
+    dns::Node node;
+    node.add( dns::Node::RRSetPtr( new dns::RRSet( "example.com", dns::CLASS_IN, dns::TYPE_MX, 3600 ) ) );
+    node.add( dns::Node::RRSetPtr( new dns::RRSet( "example.com", dns::CLASS_IN, dns::TYPE_A, 3600 ) ) );
+    node.add( dns::Node::RRSetPtr( new dns::RRSet( "example.com", dns::CLASS_IN, dns::TYPE_NS, 86400 ) ) );
+    node.add( dns::Node::RRSetPtr( new dns::RRSet( "example.com", dns::CLASS_IN, dns::TYPE_A, 300 ) ) );
+
+    std::vector<dns::Type> types = node.getTypes();
+    ASSERT_EQ( 3, types.size() );
+    EXPECT_EQ( dns::TYPE_A,  types[ 0 ] );
+    EXPECT_EQ( dns::TYPE_NS, types[ 1 ] );
+    EXPECT_EQ( dns::TYPE_MX, types[ 2 ] );
+
+    EXPECT_EQ( 3600, node.find( dns::TYPE_A )->getTTL() );
+    EXPECT_FALSE( node.find( dns::TYPE_AAAA ) );
+    EXPECT_FALSE( node.find( dns::TYPE_TXT ) );
+}
+
+
+class NodeTreeTest : public ::testing::Test
+{
+
+public:
+    virtual void SetUp()
+    {
+    }
+
+    virtual void TearDown()
+    {
+    }
+};
+
+TEST_F( NodeTreeTest, AddAndFind )
+{
+    dns::NodeTree tree( "example.com" );
+    auto node = tree.add( "WWW.a.b.Example.com" );
+
+    EXPECT_EQ( node, tree.find( "www.A.B.example.COM" ) );
+    EXPECT_TRUE( tree.find( "a.b.example.com" ).get() != nullptr );  // empty non-terminal
+    EXPECT_TRUE( tree.find( "b.example.com" ).get() != nullptr );
+    EXPECT_TRUE( tree.find( "example.com" ).get() != nullptr );
+    EXPECT_FALSE( tree.find( "c.example.com" ) );
+    EXPECT_FALSE( tree.find( "www.example.net" ) );
+    EXPECT_EQ( 4, tree.size() );
+
+    EXPECT_EQ( node, tree.add( "www.a.b.example.com" ) );
+    EXPECT_EQ( 4, tree.size() );
+    EXPECT_THROW( { tree.add( "www.example.net" ); }, std::logic_error );
+}
+
+TEST_F( NodeTreeTest, Lookup )
+{
+    dns::NodeTree tree( "example.com" );
+    tree.add( "*.example.com" );
+    tree.add( "*.wild.example.com" );
+    tree.add( "www.wild.example.com" );
+
+    dns::Node::RRSetPtr ns( new dns::RRSet( "sub.example.com", dns::CLASS_IN, dns::TYPE_NS, 3600 ) );
+    ns->add( dns::RDATAPtr( new dns::RecordNS( "ns.sub.example.com" ) ) );
+    tree.add( "sub.example.com" )->add( ns );
+    tree.add( "ns.sub.example.com" );
+
+    dns::NodeTree::LookupResult result = tree.lookup( "www.wild.example.com" );
+    ASSERT_TRUE( result.mNode != nullptr );
+    EXPECT_EQ( dns::Domainname( "www.wild.example.com" ), result.mNode->first );
+    EXPECT_EQ( result.mNode, result.mClosestEncloser );
+
+    result = tree.lookup( "a.b.wild.example.com" );
+    EXPECT_TRUE( result.mNode == nullptr );
+    EXPECT_EQ( dns::Domainname( "wild.example.com" ), result.mClosestEncloser->first );
+    EXPECT_EQ( dns::Domainname( "*.wild.example.com" ), result.mWildcard->first );
+    EXPECT_TRUE( result.mDelegation == nullptr );
+
+    result = tree.lookup( "a.example.com" );
+    EXPECT_EQ( dns::Domainname( "example.com" ), result.mClosestEncloser->first );
+    EXPECT_EQ( dns::Domainname( "*.example.com" ), result.mWildcard->first );
+
+    result = tree.lookup( "www.ns.sub.example.com" );
+    EXPECT_EQ( dns::Domainname( "ns.sub.example.com" ), result.mClosestEncloser->first );
+    ASSERT_TRUE( result.mDelegation != nullptr );
+    EXPECT_EQ( dns::Domainname( "sub.example.com" ), result.mDelegation->first );
+
+    dns::Node::RRSetPtr dname( new dns::RRSet( "dn.example.com", dns::CLASS_IN, dns::TYPE_DNAME, 3600 ) );
+    dname->add( dns::RDATAPtr( new dns::RecordDNAME( "example.net" ) ) );
+    tree.add( "dn.example.com" )->add( dname );
+
+    result = tree.lookup( "a.b.dn.example.com" );
+    EXPECT_EQ( dns::Domainname( "dn.example.com" ), result.mClosestEncloser->first );
+    ASSERT_TRUE( result.mDNAME != nullptr );
+    EXPECT_EQ( dns::Domainname( "dn.example.com" ), result.mDNAME->first );
+    EXPECT_TRUE( result.mDelegation == nullptr );
+
+    result = tree.lookup( "www.example.net" );
+    EXPECT_TRUE( result.mNode == nullptr );
+    EXPECT_TRUE( result.mClosestEncloser == nullptr );
+}
+
 
 class ZoneTest : public ::testing::Test
 {
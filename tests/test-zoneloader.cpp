@@ -270,6 +270,7 @@ const char *ZONE_CONFIG_FULL_A = \
 TEST_F( ZoneLoaderTest, Load_Full_A )
 {
     dns::UnsignedZone zone( "example.com" );
+    size_t arena_size = zone.getArena()->getAllocatedSize();
     ASSERT_NO_THROW( {
             try {
                 dns::full::load( zone, "example.com", ZONE_CONFIG_FULL_A );
@@ -287,6 +288,8 @@ TEST_F( ZoneLoaderTest, Load_Full_A )
     auto rrset = zone.findRRSet( "www.example.com", dns::TYPE_A );
     EXPECT_FALSE( rrset.get() == nullptr ) <<  "a records are loaded from FULL";
     EXPECT_EQ( 2, rrset->count() ) << "2 A records are loaded from FULL";
+    EXPECT_TRUE( rrset->isCompiled() ) << "RRSet of multiple records is precompiled";
+    EXPECT_LT( arena_size, zone.getArena()->getAllocatedSize() ) << "records are allocated from arena of zone";
  
     std::shared_ptr<const dns::RecordA> a;
     ASSERT_NO_THROW( {
@@ -303,6 +306,23 @@ TEST_F( ZoneLoaderTest, Load_Full_A )
 
 const char *ZONE_CONFIG_FULL_NSEC = "ns01.example.com. 3600 IN NSEC  ns02.example.com. A RRSIG NSEC";
 
+TEST_F( ZoneLoaderTest, Load_Full_RDATAOutlivesZone )
+{
+    dns::ConstRDATAPtr            rdata;
+    std::weak_ptr<utils::Arena>   arena;
+    {
+        dns::UnsignedZone zone( "example.com" );
+        dns::full::load( zone, "example.com", ZONE_CONFIG_FULL_A );
+        arena = zone.getArena();
+        rdata = ( *zone.findRRSet( "www.example.com", dns::TYPE_A ) )[0];
+    }
+    EXPECT_FALSE( arena.expired() ) << "RDATA copied out of the zone keeps the arena";
+    EXPECT_EQ( "192.168.0.101", std::dynamic_pointer_cast<const dns::RecordA>( rdata )->getAddress() );
+
+    rdata.reset();
+    EXPECT_TRUE( arena.expired() );
+}
+
 TEST_F( ZoneLoaderTest, Load_Full_NSEC )
 {
     dns::UnsignedZone zone( "example.com" );